@@ -1,56 +1,85 @@
+#include <cctype>
 #include <chrono>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 #include "alphabet_index.hpp"
+#include "bplus_tree.hpp"
+#include "buffered_writer.hpp"
+#include "corpus.hpp"
+#include "filtered_dictionary.hpp"
 #include "flat_table.hpp"
 #include "hash_table.hpp"
+#include "isorted_dictionary.hpp"
+#include "parallel.hpp"
+#include "perfect_hash_table.hpp"
+#include "stats.hpp"
+#include "trie_table.hpp"
 
 using Clock = std::chrono::steady_clock;
 
+// std::hash cut down to kCollisionModulus values, for the adversarial
+// benchmark (--backend=weakhash): on the collide corpus every word gets the
+// same full hash, so rehashing cannot split the chain.
+struct TruncatedHash {
+    size_t operator()(const std::string& key) const {
+        return std::hash<std::string>()(key) % kCollisionModulus;
+    }
+};
+
+using WeakHashTable = HashTable<std::string, int, TruncatedHash>;
+
 struct CliOptions {
     std::string file_path;
     size_t page_size = 100;
     size_t line_size = 0;
     AlphabetIndexMode mode = AlphabetIndexMode::Words;
-    std::string backend = "hash";  // hash | flat | both
+    std::string backend = "hash";  // hash | flat | btree | trie | perfect | weakhash | both
+    bool concordance = false;
+    bool concordance_lines = false;
+    std::string query;
+    std::string scan;
     bool bench = false;
     std::vector<size_t> bench_iters = {30000, 40000, 50000, 60000, 70000};
     std::vector<size_t> bench_gen_sizes = {1000, 5000};
+    double miss_ratio = 0.0;
+    bool filter = false;
     size_t gen_count = 0;
     size_t gen_max_len = 8;
+    CorpusOptions corpus;
     std::string export_csv;
     std::string export_book;
     std::string export_bench_csv;
+    std::string save_index;
+    size_t threads = 0;
+    std::string stats_json;
+    KeyOptions keys;
+    bool help = false;
 };
 
-std::string ReadText(const std::string& file_path) {
+std::string ReadText(const std::string& file_path, bool prompt) {
     if (!file_path.empty()) {
         std::ifstream ifs(file_path);
         std::ostringstream ss;
         ss << ifs.rdbuf();
         return ss.str();
     }
-    std::cout << "Введите текст (Ctrl+D для завершения ввода):\n";
+    if (prompt) {
+        std::cout << "Введите текст (Ctrl+D для завершения ввода):\n";
+    }
     std::ostringstream ss;
     ss << std::cin.rdbuf();
     return ss.str();
 }
 
-std::string GenerateText(size_t count, size_t max_len) {
-    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz";
-    std::ostringstream ss;
-    for (size_t i = 0; i < count; ++i) {
-        size_t len = 1 + (i % max_len);
-        for (size_t j = 0; j < len; ++j) {
-            ss << alphabet[(i + j) % (sizeof(alphabet) - 1)];
-        }
-        ss << ' ';
-    }
-    return ss.str();
+std::string GenerateText(const CliOptions& opt, size_t count) {
+    CorpusOptions corpus = opt.corpus;
+    corpus.max_length = opt.gen_max_len;
+    return GenerateCorpus(count, corpus);
 }
 
 CliOptions InteractiveDialog() {
@@ -85,16 +114,31 @@ CliOptions InteractiveDialog() {
     if (!line.empty() && (line[0] == 'c' || line[0] == 'C'))
         opt.mode = AlphabetIndexMode::Chars;
 
-    std::cout << "5) Структура (h=hash, f=flat, b=both) [h]: ";
+    std::cout << "5) Структура (h=hash, f=flat, e=btree, t=trie, p=perfect, b=both) [h]: ";
     std::getline(std::cin, line);
     if (!line.empty()) {
         if (line[0] == 'f' || line[0] == 'F')
             opt.backend = "flat";
+        else if (line[0] == 'e' || line[0] == 'E')
+            opt.backend = "btree";
+        else if (line[0] == 't' || line[0] == 'T')
+            opt.backend = "trie";
+        else if (line[0] == 'p' || line[0] == 'P')
+            opt.backend = "perfect";
         else if (line[0] == 'b' || line[0] == 'B')
             opt.backend = "both";
     }
 
-    std::cout << "6) Запустить бенчмарк? (y/n) [n]: ";
+    std::cout << "6) Конкорданс: (n)o / (p)ages / (l)ines [n]: ";
+    std::getline(std::cin, line);
+    if (!line.empty() && (line[0] == 'p' || line[0] == 'P' || line[0] == 'l' || line[0] == 'L')) {
+        opt.concordance = true;
+        opt.concordance_lines = (line[0] == 'l' || line[0] == 'L');
+        std::cout << "   Запрос: слова через пробел (пусто — пропустить): ";
+        std::getline(std::cin, opt.query);
+    }
+
+    std::cout << "7) Запустить бенчмарк? (y/n) [n]: ";
     std::getline(std::cin, line);
     if (!line.empty() && (line[0] == 'y' || line[0] == 'Y')) {
         opt.bench = true;
@@ -124,31 +168,400 @@ CliOptions InteractiveDialog() {
             if (opt.bench_gen_sizes.empty())
                 opt.bench_gen_sizes = {1000, 5000};
         }
+        std::cout << "   Корпус: (z)ipf / (c)yclic / (h)ash-collide / (p)refix [z]: ";
+        std::getline(std::cin, line);
+        if (!line.empty()) {
+            if (line[0] == 'c' || line[0] == 'C')
+                opt.corpus.kind = CorpusKind::Cyclic;
+            else if (line[0] == 'h' || line[0] == 'H')
+                opt.corpus.kind = CorpusKind::Collide;
+            else if (line[0] == 'p' || line[0] == 'P')
+                opt.corpus.kind = CorpusKind::Prefix;
+        }
+        std::cout << "   Доля запросов отсутствующих слов (0..1) [0]: ";
+        std::getline(std::cin, line);
+        if (!line.empty())
+            opt.miss_ratio = std::stod(line);
         std::cout << "   Путь для CSV с бенчмарком (пусто — в stdout): ";
         std::getline(std::cin, opt.export_bench_csv);
     }
 
-    std::cout << "7) Экспорт разбиения в CSV (оставьте пустым, чтобы пропустить): ";
+    std::cout << "8) Экспорт разбиения в CSV (оставьте пустым, чтобы пропустить): ";
     std::getline(std::cin, opt.export_csv);
-    std::cout << "8) Экспорт книги в TXT (путь файла или '-' для stdout, пусто — пропустить): ";
+    std::cout << "9) Экспорт книги в TXT (путь файла или '-' для stdout, пусто — пропустить): ";
     std::getline(std::cin, opt.export_book);
+    std::cout << "10) Просмотр указателя: префикс 'abc*' или диапазон 'a..c' (пусто — весь указатель): ";
+    std::getline(std::cin, opt.scan);
+    std::cout << "11) Число потоков для сортировки (0 = по числу ядер) [0]: ";
+    std::getline(std::cin, line);
+    if (!line.empty())
+        opt.threads = std::stoul(line);
+    std::cout << "12) Фильтр Блума перед указателем? (y/n) [n]: ";
+    std::getline(std::cin, line);
+    opt.filter = !line.empty() && (line[0] == 'y' || line[0] == 'Y');
+    std::cout << "13) Ключи указателя: (a)s is / (p)unct strip / (c)ase fold / (b)oth [a]: ";
+    std::getline(std::cin, line);
+    if (!line.empty()) {
+        opt.keys.strip_punctuation = (line[0] == 'p' || line[0] == 'P' || line[0] == 'b' || line[0] == 'B');
+        opt.keys.fold_case = (line[0] == 'c' || line[0] == 'C' || line[0] == 'b' || line[0] == 'B');
+    }
     return opt;
 }
 
+// Parses a whole non-negative integer. std::stoull alone would accept "-1"
+// (wrapping to SIZE_MAX) and trailing garbage such as "10abc".
+size_t ParseSize(const std::string& value, const std::string& flag) {
+    size_t pos = 0;
+    if (value.empty() || value[0] < '0' || value[0] > '9') {
+        throw std::invalid_argument(flag + ": " + value);
+    }
+    size_t res = std::stoull(value, &pos);
+    if (pos != value.size()) {
+        throw std::invalid_argument(flag + ": " + value);
+    }
+    return res;
+}
+
+double ParseDouble(const std::string& value, const std::string& flag) {
+    size_t pos = 0;
+    if (value.empty() || std::isspace(static_cast<unsigned char>(value[0]))) {
+        throw std::invalid_argument(flag + ": " + value);
+    }
+    double res = std::stod(value, &pos);
+    if (pos != value.size()) {
+        throw std::invalid_argument(flag + ": " + value);
+    }
+    return res;
+}
+
+std::vector<size_t> ParseSizeList(const std::string& value, const std::string& flag) {
+    std::vector<size_t> res;
+    std::stringstream ss(value);
+    std::string token;
+    while (std::getline(ss, token, ',')) {
+        if (!token.empty())
+            res.push_back(ParseSize(token, flag));
+    }
+    return res;
+}
+
+void PrintUsage(std::ostream& out) {
+    out << "Использование: alphabet_cli [флаги] (без флагов — интерактивный диалог)\n"
+           "  --file=PATH             текст из файла (по умолчанию — stdin)\n"
+           "  --generate=N            сгенерировать N слов вместо чтения текста\n"
+           "  --max-len=N             максимальная длина генерируемого слова [8]\n"
+           "  --page-size=N           размер страницы [100]\n"
+           "  --line-size=N           размер строки, 0 = авто [0]\n"
+           "  --mode=words|chars      режим разбиения [words]\n"
+           "  --backend=hash|flat|btree|trie|perfect|weakhash|both  структура указателя [hash]\n"
+           "  --concordance[=pages|lines]    построить конкорданс\n"
+           "  --query=WORDS           запрос к конкордансу (слова через пробел)\n"
+           "  --scan=PATTERN          префикс 'abc*' или диапазон 'a..c'\n"
+           "  --strip-punct           отбрасывать пунктуацию по краям ключей\n"
+           "  --fold-case             приводить ключи к нижнему регистру\n"
+           "  --corpus=zipf|cyclic|collide|prefix  генерируемый корпус [zipf]\n"
+           "  --seed=N                зерно генератора [1]\n"
+           "  --vocab=N               размер словаря корпуса [10000]\n"
+           "  --zipf=S                показатель распределения Ципфа [1.0]\n"
+           "  --bench                 запустить бенчмарк\n"
+           "  --bench-iters=A,B,...   числа запросов бенчмарка\n"
+           "  --bench-sizes=A,B,...   размеры генерируемых текстов бенчмарка\n"
+           "  --miss-ratio=R          доля запросов отсутствующих слов в бенчмарке [0]\n"
+           "  --filter                фильтр Блума перед указателем\n"
+           "  --export-csv=PATH       экспорт разбиения в CSV\n"
+           "  --export-book=PATH      экспорт книги в TXT ('-' — stdout)\n"
+           "  --export-bench-csv=PATH CSV с бенчмарком (по умолчанию — stdout)\n"
+           "  --save-index=PATH       сохранить замороженный указатель (perfect hash), не с --bench\n"
+           "  --threads=N             число потоков, 0 = по числу ядер [0]\n"
+           "  --stats-json=PATH       счётчики инструментирования в JSON ('-' — stdout)\n"
+           "  --help                  эта справка\n";
+}
+
+// Fills `opt` from "--flag=value" or "--flag value" arguments. Returns false
+// and sets `error` on an unknown flag or a malformed value.
+bool ParseArgs(int argc, char** argv, CliOptions& opt, std::string& error) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            error = "Неожиданный аргумент: " + arg;
+            return false;
+        }
+        std::string name = arg.substr(2);
+        std::string value;
+        bool has_value = false;
+        if (auto eq = name.find('='); eq != std::string::npos) {
+            value = name.substr(eq + 1);
+            name = name.substr(0, eq);
+            has_value = true;
+        }
+        auto take_value = [&]() {
+            if (!has_value) {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("--" + name + " требует значение");
+                }
+                value = argv[++i];
+                has_value = true;
+            }
+            return value;
+        };
+        auto take_size = [&]() { return ParseSize(take_value(), "--" + name); };
+        auto take_double = [&]() { return ParseDouble(take_value(), "--" + name); };
+        // Switches take no value or an explicit true/false.
+        auto take_switch = [&]() {
+            if (!has_value || value == "true") {
+                return true;
+            }
+            if (value == "false") {
+                return false;
+            }
+            throw std::invalid_argument("--" + name + ": " + value);
+        };
+        try {
+            if (name == "help") {
+                opt.help = take_switch();
+            } else if (name == "file") {
+                opt.file_path = take_value();
+            } else if (name == "generate") {
+                opt.gen_count = take_size();
+            } else if (name == "max-len") {
+                opt.gen_max_len = take_size();
+            } else if (name == "corpus") {
+                if (!ParseCorpusKind(take_value(), opt.corpus.kind)) {
+                    throw std::invalid_argument("--corpus: " + value);
+                }
+            } else if (name == "seed") {
+                opt.corpus.seed = take_size();
+            } else if (name == "vocab") {
+                opt.corpus.vocabulary = take_size();
+            } else if (name == "zipf") {
+                opt.corpus.zipf_s = take_double();
+            } else if (name == "page-size") {
+                opt.page_size = take_size();
+            } else if (name == "line-size") {
+                opt.line_size = take_size();
+            } else if (name == "mode") {
+                take_value();
+                if (value == "words") {
+                    opt.mode = AlphabetIndexMode::Words;
+                } else if (value == "chars") {
+                    opt.mode = AlphabetIndexMode::Chars;
+                } else {
+                    throw std::invalid_argument("--mode: " + value);
+                }
+            } else if (name == "backend") {
+                take_value();
+                if (value != "hash" && value != "flat" && value != "btree" && value != "trie" && value != "perfect" &&
+                    value != "weakhash" && value != "both") {
+                    throw std::invalid_argument("--backend: " + value);
+                }
+                opt.backend = value;
+            } else if (name == "concordance") {
+                if (has_value && value != "pages" && value != "lines") {
+                    throw std::invalid_argument("--concordance: " + value);
+                }
+                opt.concordance = true;
+                opt.concordance_lines = (value == "lines");
+            } else if (name == "query") {
+                opt.query = take_value();
+            } else if (name == "scan") {
+                opt.scan = take_value();
+            } else if (name == "strip-punct") {
+                opt.keys.strip_punctuation = take_switch();
+            } else if (name == "fold-case") {
+                opt.keys.fold_case = take_switch();
+            } else if (name == "bench") {
+                opt.bench = take_switch();
+            } else if (name == "bench-iters") {
+                opt.bench_iters = ParseSizeList(take_value(), "--" + name);
+            } else if (name == "bench-sizes") {
+                opt.bench_gen_sizes = ParseSizeList(take_value(), "--" + name);
+            } else if (name == "miss-ratio") {
+                opt.miss_ratio = take_double();
+                if (opt.miss_ratio < 0.0 || opt.miss_ratio > 1.0) {
+                    throw std::invalid_argument("--miss-ratio: " + value);
+                }
+            } else if (name == "filter") {
+                opt.filter = take_switch();
+            } else if (name == "export-csv") {
+                opt.export_csv = take_value();
+            } else if (name == "export-book") {
+                opt.export_book = take_value();
+            } else if (name == "export-bench-csv") {
+                opt.export_bench_csv = take_value();
+            } else if (name == "save-index") {
+                opt.save_index = take_value();
+            } else if (name == "threads") {
+                opt.threads = take_size();
+            } else if (name == "stats-json") {
+                opt.stats_json = take_value();
+            } else {
+                error = "Неизвестный флаг: --" + name;
+                return false;
+            }
+        } catch (const std::invalid_argument& e) {
+            error = std::string("Некорректное значение: ") + e.what();
+            return false;
+        } catch (const std::out_of_range&) {
+            error = "Слишком большое значение: --" + name;
+            return false;
+        }
+    }
+    if (opt.bench && !opt.save_index.empty()) {
+        error = "--save-index нельзя сочетать с --bench";
+        return false;
+    }
+    return true;
+}
+
 template <typename DictPtr>
 void ExportCsv(const DictPtr& dict, const std::string& path) {
     if (path.empty())
         return;
-    std::ofstream ofs(path);
+    std::ofstream file(path);
+    BufferedWriter ofs(file);
     ofs << "word,page\n";
-    auto it = dict->GetIterator();
-    while (it->HasNext()) {
-        auto kv = it->GetCurrentItem();
-        ofs << kv.key << "," << kv.value << "\n";
-        it->Next();
+    for (auto it = dict->GetSortedIterator(); it->HasNext(); it->Next()) {
+        const auto& kv = it->GetCurrentItem();
+        ofs << kv.key << ',' << kv.value << '\n';
     }
 }
 
+void ExportConcordanceCsv(const IDictionaryPtr<std::string, PostingListPtr>& dict, const std::string& path) {
+    if (path.empty())
+        return;
+    std::ofstream file(path);
+    BufferedWriter ofs(file);
+    ofs << "word,pages\n";
+    for (auto it = dict->GetSortedIterator(); it->HasNext(); it->Next()) {
+        const auto& kv = it->GetCurrentItem();
+        ofs << kv.key << ",";
+        bool first = true;
+        for (PostingCursor cur(*kv.value); cur.IsValid(); cur.Next()) {
+            if (!first)
+                ofs << ";";
+            ofs << cur.GetCurrent().page;
+            if (kv.value->GetWithLines())
+                ofs << ":" << cur.GetCurrent().line;
+            first = false;
+        }
+        ofs << "\n";
+    }
+}
+
+void RunQuery(const IDictionaryPtr<std::string, PostingListPtr>& dict, const std::vector<std::string>& words) {
+    ArraySequence<PostingListPtr> lists;
+    for (const auto& w : words) {
+        if (!dict->ContainsKey(w)) {
+            std::cout << "Нет совпадений\n";
+            return;
+        }
+        lists.Append(dict->Get(w));
+    }
+    auto pages = IntersectPages(lists);
+    if (pages->GetLength() == 0) {
+        std::cout << "Нет совпадений\n";
+        return;
+    }
+    std::cout << "Страницы:";
+    for (auto it = pages->GetIterator(); it->HasNext(); it->Next()) {
+        std::cout << " " << it->GetCurrentItem();
+    }
+    std::cout << "\n";
+}
+
+// Prints the index entries selected by `scan`: "abc*" is a prefix query and
+// "lo..hi" a half-open key range (an empty bound is open-ended). Sorted
+// backends answer from their ordered storage, the rest fall back to a sorted
+// scan.
+void PrintScan(const IDictionaryPtr<std::string, int>& dict, const std::string& scan) {
+    std::string lo = scan;
+    std::string hi;
+    bool prefix = true;
+    if (auto sep = scan.find(".."); sep != std::string::npos) {
+        lo = scan.substr(0, sep);
+        hi = scan.substr(sep + 2);
+        prefix = false;
+    } else if (!lo.empty() && lo.back() == '*') {
+        lo.pop_back();
+    }
+    auto matches = [&](const std::string& key) {
+        if (prefix) {
+            return key.compare(0, lo.size(), lo) == 0;
+        }
+        return key >= lo && (hi.empty() || key < hi);
+    };
+
+    IIteratorPtr<KeyValue<std::string, int>> it;
+    if (auto sorted = std::dynamic_pointer_cast<ISortedDictionary<std::string, int>>(dict)) {
+        it = prefix ? sorted->ScanPrefix(lo) : (hi.empty() ? sorted->RangeFrom(lo) : sorted->Range(lo, hi));
+    } else {
+        it = dict->GetSortedIterator();
+    }
+    for (; it->HasNext(); it->Next()) {
+        const auto& kv = it->GetCurrentItem();
+        if (matches(kv.key)) {
+            std::cout << kv.key << " -> " << kv.value << "\n";
+        }
+    }
+}
+
+template <typename Dict>
+Book BuildWith(const CliOptions& opt, const std::string& text) {
+    if (opt.concordance) {
+        using Concordance = HashTable<std::string, PostingListPtr>;
+        return BuildConcordanceBook<Dict, Concordance>(text, opt.page_size, opt.mode, opt.line_size,
+                                                       ConcordanceOptions{opt.concordance_lines, opt.keys});
+    }
+    return BuildBook<Dict>(text, opt.page_size, opt.mode, opt.line_size, DefaultResource(), opt.keys);
+}
+
+// One JSON object per built book: pipeline stage counters and, for backends
+// that keep them, lookup counters (including the benchmark queries).
+void WriteRunStats(std::ostream& out, const std::string& name, size_t text_size, const Book& book) {
+    out << "{\"backend\":\"" << name << "\",\"text_size\":" << text_size << ",\"pipeline\":";
+    WriteJson(out, book.stats);
+    IDictionaryPtr<std::string, int> index = book.index;
+    if (auto filtered = std::dynamic_pointer_cast<FilteredDictionary<std::string, int>>(index)) {
+        out << ",\"filter\":";
+        WriteJson(out, filtered->GetStats());
+        index = filtered->GetInner();
+    }
+    out << ",\"capacity\":" << index->GetCapacity();
+    if (auto hash = std::dynamic_pointer_cast<HashTable<std::string, int>>(index)) {
+        out << ",\"index\":";
+        WriteJson(out, hash->GetStats());
+    } else if (auto weak = std::dynamic_pointer_cast<WeakHashTable>(index)) {
+        out << ",\"index\":";
+        WriteJson(out, weak->GetStats());
+    } else if (auto flat = std::dynamic_pointer_cast<FlatTable<std::string, int>>(index)) {
+        out << ",\"index\":";
+        WriteJson(out, flat->GetStats());
+    } else if (auto btree = std::dynamic_pointer_cast<BPlusTree<std::string, int>>(index)) {
+        out << ",\"index\":";
+        WriteJson(out, btree->GetStats());
+    } else if (auto perfect = std::dynamic_pointer_cast<PerfectHashTable<int>>(index)) {
+        out << ",\"index\":";
+        WriteJson(out, perfect->GetStats());
+    }
+    out << "}";
+}
+
+// Benchmark queries: the text's words with about `miss_ratio` of them
+// replaced by words that are not in the index.
+std::vector<std::string> MixMisses(const std::vector<std::string>& words, double miss_ratio, uint64_t seed) {
+    std::vector<std::string> res = words;
+    if (miss_ratio <= 0.0) {
+        return res;
+    }
+    SplitMix64 rng(seed);
+    for (auto& word : res) {
+        if (rng.NextDouble() < miss_ratio) {
+            word += "#miss";
+        }
+    }
+    return res;
+}
+
 template <typename DictPtr>
 double Benchmark(const DictPtr& dict, const std::vector<std::string>& words, size_t iters) {
     if (words.empty() || iters == 0)
@@ -167,60 +580,127 @@ double Benchmark(const DictPtr& dict, const std::vector<std::string>& words, siz
 }
 
 int main(int argc, char** argv) {
-    CliOptions opt = InteractiveDialog();
-    auto tokenize = [](const std::string& text) {
+    const bool interactive = argc <= 1;
+    CliOptions opt;
+    if (interactive) {
+        opt = InteractiveDialog();
+    } else {
+        std::string error;
+        if (!ParseArgs(argc, argv, opt, error)) {
+            std::cerr << error << "\n";
+            PrintUsage(std::cerr);
+            return 2;
+        }
+        if (opt.help) {
+            PrintUsage(std::cout);
+            return 0;
+        }
+    }
+    SetThreadCount(opt.threads);
+    // Words of `text` as index keys, so that queries match normalized keys.
+    auto tokenize = [&opt](const std::string& text) {
         StringCharStream chars(text);
-        LexerStream lex(chars);
+        BasicLexerStream<StringCharStream> lex(chars);
         std::vector<std::string> res;
         std::string tok;
         while (lex.Read(tok))
-            res.push_back(tok);
+            WithIndexKey(tok, opt.keys, [&](const std::string& key) { res.push_back(key); });
         return res;
     };
 
-    std::string base_text = opt.gen_count ? GenerateText(opt.gen_count, opt.gen_max_len) : ReadText(opt.file_path);
+    std::string base_text =
+        opt.gen_count ? GenerateText(opt, opt.gen_count) : ReadText(opt.file_path, interactive);
     std::vector<std::string> base_words = tokenize(base_text);
 
     auto print_dict = [](const auto& dict) {
-        auto it = dict->GetIterator();
-        while (it->HasNext()) {
-            auto kv = it->GetCurrentItem();
-            std::cout << kv.key << " -> " << kv.value << "\n";
-            it->Next();
+        BufferedWriter out(std::cout);
+        for (auto it = dict->GetSortedIterator(); it->HasNext(); it->Next()) {
+            const auto& kv = it->GetCurrentItem();
+            out << kv.key << " -> " << kv.value << '\n';
         }
     };
 
     struct BenchRow {
         std::string backend;
+        std::string corpus;
+        bool filter;
+        double miss_ratio;
         size_t text_size;
         size_t queries;
         double build_ms;
         double query_ms;
     };
     std::vector<BenchRow> bench_results;
+    std::vector<std::string> run_stats;
     bool book_saved = false;
+    bool index_saved = false;
+    std::string corpus_name = opt.gen_count ? CorpusKindName(opt.corpus.kind) : "input";
 
     auto run_backend = [&](const std::string& name, const std::string& text, const std::vector<std::string>& words) {
         auto build_start = Clock::now();
-        auto book = (name == "flat") ? BuildBook<FlatTable<std::string, int>>(text, opt.page_size, opt.mode, opt.line_size)
-                                     : BuildBook<HashTable<std::string, int>>(text, opt.page_size, opt.mode, opt.line_size);
+        Book book = (name == "flat")      ? BuildWith<FlatTable<std::string, int>>(opt, text)
+                    : (name == "btree")   ? BuildWith<BPlusTree<std::string, int>>(opt, text)
+                    : (name == "trie")    ? BuildWith<TrieTable<int>>(opt, text)
+                    : (name == "perfect") ? BuildWith<PerfectHashTable<int>>(opt, text)
+                    : (name == "weakhash") ? BuildWith<WeakHashTable>(opt, text)
+                                          : BuildWith<HashTable<std::string, int>>(opt, text);
+        if (opt.filter) {
+            book.index = WithFilter(book.index);
+        }
         auto dict = book.index;
         double build_ms = std::chrono::duration<double, std::milli>(Clock::now() - build_start).count();
-        ExportCsv(dict, opt.export_csv);
+        if (book.concordance != nullptr) {
+            ExportConcordanceCsv(book.concordance, opt.export_csv);
+        } else {
+            ExportCsv(dict, opt.export_csv);
+        }
         if (!opt.export_book.empty() && !opt.bench && !book_saved) {
             if (!SaveBook(book, opt.export_book)) {
                 std::cerr << "Не удалось сохранить книгу: " << opt.export_book << "\n";
             }
             book_saved = true;
         }
+        // With --backend=both the index of the first backend is saved.
+        if (!opt.save_index.empty() && !index_saved) {
+            auto frozen = std::dynamic_pointer_cast<PerfectHashTable<int>>(dict);
+            if (frozen == nullptr) {
+                frozen = Freeze(*dict);
+            }
+            std::ofstream file(opt.save_index, std::ios::binary);
+            if (!frozen->Serialize(file)) {
+                std::cerr << "Не удалось сохранить указатель: " << opt.save_index << "\n";
+            }
+            index_saved = true;
+        }
         if (opt.bench) {
+            auto queries = MixMisses(words, opt.miss_ratio, opt.corpus.seed);
             for (auto q : opt.bench_iters) {
-                double ms = Benchmark(dict, words, q);
-                bench_results.push_back({name, words.size(), q, build_ms, ms});
+                double ms = Benchmark(dict, queries, q);
+                bench_results.push_back(
+                    {name, corpus_name, opt.filter, opt.miss_ratio, words.size(), q, build_ms, ms});
+            }
+        } else if (book.concordance != nullptr) {
+            {
+                BufferedWriter out(std::cout);
+                for (auto it = book.concordance->GetSortedIterator(); it->HasNext(); it->Next()) {
+                    const auto& kv = it->GetCurrentItem();
+                    out << kv.key << " -> ";
+                    FormatPostings(out, *kv.value) << '\n';
+                }
             }
+            if (!opt.query.empty()) {
+                RunQuery(book.concordance, tokenize(opt.query));
+            }
+        } else if (!opt.scan.empty()) {
+            PrintScan(dict, opt.scan);
         } else {
             print_dict(dict);
         }
+        if (!opt.stats_json.empty()) {
+            std::ostringstream ss;
+            WriteRunStats(ss, name, words.size(), book);
+            run_stats.push_back(ss.str());
+        }
     };
 
     auto process_text = [&](const std::string& text, const std::vector<std::string>& words, bool allow_print) {
@@ -230,6 +710,18 @@ int main(int argc, char** argv) {
         if (opt.backend == "hash" || opt.backend == "both") {
             run_backend("hash", text, words);
         }
+        if (opt.backend == "trie") {
+            run_backend("trie", text, words);
+        }
+        if (opt.backend == "btree") {
+            run_backend("btree", text, words);
+        }
+        if (opt.backend == "perfect") {
+            run_backend("perfect", text, words);
+        }
+        if (opt.backend == "weakhash") {
+            run_backend("weakhash", text, words);
+        }
         (void)allow_print;  // printing уже внутри
     };
 
@@ -239,7 +731,8 @@ int main(int argc, char** argv) {
         if (opt.bench_gen_sizes.empty())
             opt.bench_gen_sizes = {1000, 5000};
         for (auto sz : opt.bench_gen_sizes) {
-            std::string txt = GenerateText(sz, opt.gen_max_len);
+            corpus_name = CorpusKindName(opt.corpus.kind);
+            std::string txt = GenerateText(opt, sz);
             auto w = tokenize(txt);
             process_text(txt, w, false);
         }
@@ -252,11 +745,26 @@ int main(int argc, char** argv) {
             file = std::make_unique<std::ofstream>(opt.export_bench_csv);
             out = file.get();
         }
-        (*out) << "backend,text_size,queries,build_ms,query_ms\n";
+        (*out) << "backend,corpus,filter,miss_ratio,text_size,queries,build_ms,query_ms\n";
         for (const auto& row : bench_results) {
-            (*out) << row.backend << "," << row.text_size << "," << row.queries << "," << row.build_ms << ","
+            (*out) << row.backend << "," << row.corpus << "," << (row.filter ? "bloom" : "none") << ","
+                   << row.miss_ratio << "," << row.text_size << "," << row.queries << "," << row.build_ms << ","
                    << row.query_ms << "\n";
         }
     }
+
+    if (!opt.stats_json.empty()) {
+        std::ostream* out = &std::cout;
+        std::unique_ptr<std::ofstream> file;
+        if (opt.stats_json != "-") {
+            file = std::make_unique<std::ofstream>(opt.stats_json);
+            out = file.get();
+        }
+        (*out) << "{\"enabled\":" << (kStatsEnabled ? "true" : "false") << ",\"runs\":[";
+        for (size_t i = 0; i < run_stats.size(); ++i) {
+            (*out) << (i == 0 ? "" : ",") << run_stats[i];
+        }
+        (*out) << "]}\n";
+    }
     return 0;
 }
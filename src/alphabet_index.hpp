@@ -1,84 +1,39 @@
 #pragma once
 
+#include <memory_resource>
 #include <string>
+#include <type_traits>
 
+#include "array_sequence.hpp"
 #include "fwd.hpp"
 #include "list_sequence.hpp"
+#include "memory.hpp"
+#include "pipeline.hpp"
+#include "postings.hpp"
 #include "sequence.hpp"
-#include "stream.hpp"
-
-enum class AlphabetIndexMode { Words, Chars };
-
-class LexerStream : public Stream<std::string> {
-public:
-    explicit LexerStream(Stream<char>& source);
-    bool Read(std::string& out) override;
-    bool IsEnd() const override;
-    bool Seek(size_t pos) override;
-
-private:
-    Stream<char>& source_;
-};
-
-struct Line {
-    SequencePtr<std::string> words;
-};
-
-struct Page {
-    int number = 0;
-    SequencePtr<Line> lines;
-};
-
-class LineRenderer : public Stream<Line> {
-public:
-    LineRenderer(Stream<std::string>& source, size_t line_limit, AlphabetIndexMode mode);
-    bool Read(Line& out) override;
-    bool IsEnd() const override;
-
-private:
-    Stream<std::string>& source_;
-    size_t line_limit_;
-    AlphabetIndexMode mode_;
-    bool has_pending_ = false;
-    std::string pending_;
-};
-
-class PaginatorStream : public Stream<Page> {
-public:
-    PaginatorStream(Stream<Line>& source, size_t page_size, AlphabetIndexMode mode);
-    bool Read(Page& out) override;
-    bool IsEnd() const override;
-
-private:
-    size_t PageCapacity(size_t page) const;
-    size_t LineWeight(const Line& line) const;
-
-private:
-    Stream<Line>& source_;
-    size_t page_size_;
-    AlphabetIndexMode mode_;
-    size_t current_page_ = 1;
-    bool has_pending_ = false;
-    Line pending_;
-};
-
-class StringCharStream : public Stream<char> {
-public:
-    explicit StringCharStream(std::string t);
-    bool Read(char& out) override;
-    bool IsEnd() const override;
-    bool Seek(size_t p) override;
-
-private:
-    std::string text_;
-    size_t pos_ = 0;
-};
+#include "small_sequence.hpp"
+#include "stats.hpp"
+#include "text_estimate.hpp"
+#include "utf8.hpp"
 
 struct Book {
+    // Set when the book was built in an arena; everything below may live in
+    // it, so it is declared first and destroyed last.
+    std::shared_ptr<std::pmr::memory_resource> arena;
     SequencePtr<Page> pages;
     IDictionaryPtr<std::string, int> index;
+    IDictionaryPtr<std::string, PostingListPtr> concordance;
+    PipelineStats stats;
 };
 
+struct ConcordanceOptions {
+    bool with_lines = false;
+    KeyOptions keys;
+};
+
+class BufferedWriter;
+
+void WriteBook(const Book& book, BufferedWriter& out);
 void WriteBook(const Book& book, std::ostream& out);
 bool SaveBook(const Book& book, const std::string& path);
 
@@ -90,27 +45,177 @@ inline size_t DefaultLineSize(size_t page_size, AlphabetIndexMode mode) {
     return half_page == 0 ? 1 : half_page;
 }
 
-template <typename Dict>
-Book BuildBook(const std::string& text, size_t page_size, AlphabetIndexMode mode, size_t line_size = 0) {
+// Rough page count used to pre-size the page array; a miss only costs a regrow.
+inline size_t ExpectedPages(size_t text_size, size_t page_size, AlphabetIndexMode mode) {
+    constexpr size_t kAverageWordBytes = 6;
+    size_t units = mode == AlphabetIndexMode::Words ? text_size / kAverageWordBytes : text_size;
+    return units / (page_size == 0 ? 1 : page_size) + 2;
+}
+
+// Runs the text through the lexer/line/page pipeline, built on concrete stage
+// types with the mode fixed at compile time.
+template <typename Mode, typename Visitor>
+SequencePtr<Page> PaginateWith(const std::string& text, size_t page_size, AlphabetIndexMode mode, size_t line_size,
+                               Visitor&& visit, std::pmr::memory_resource* resource, PipelineStats* stats) {
     StringCharStream char_stream(text);
-    LexerStream lexer(char_stream);
+    BasicLexerStream<StringCharStream> lexer(char_stream);
     const size_t line_limit = (line_size == 0) ? DefaultLineSize(page_size, mode) : line_size;
-    LineRenderer lines(lexer, line_limit, mode);
-    PaginatorStream paginator(lines, page_size, mode);
-    auto pages = std::make_shared<ListSequence<Page>>();
-    auto index = std::make_shared<Dict>();
+    BasicLineRenderer<decltype(lexer), Mode> lines(lexer, line_limit, mode, resource);
+    BasicPaginatorStream<decltype(lines), Mode> paginator(lines, page_size, mode, resource);
+    auto pages = MakeShared<ArraySequence<Page>>(resource, resource);
+    pages->Reserve(ExpectedPages(text.size(), page_size, mode));
     Page page;
     while (paginator.Read(page)) {
         pages->Append(page);
-        for (auto lit = page.lines->GetIterator(); lit->HasNext(); lit->Next()) {
+        int line_no = 1;
+        for (auto lit = page.lines->GetIterator(); lit->HasNext(); lit->Next(), ++line_no) {
             const auto& line = lit->GetCurrentItem();
             for (auto wit = line.words->GetIterator(); wit->HasNext(); wit->Next()) {
-                const auto& word = wit->GetCurrentItem();
-                if (!index->ContainsKey(word)) {
-                    index->Add(word, page.number);
-                }
+                visit(wit->GetCurrentItem(), page.number, line_no);
             }
         }
     }
-    return Book{std::move(pages), std::move(index)};
+    if (stats != nullptr) {
+        *stats = PipelineStats{lexer.GetStats(), lines.GetStats(), paginator.GetStats()};
+    }
+    return pages;
+}
+
+// Runs the text through the lexer/line/page pipeline and calls
+// visit(word, page_number, line_number) for every word in reading order.
+// Stage counters are stored in `stats` when it is given.
+template <typename Visitor>
+SequencePtr<Page> Paginate(const std::string& text, size_t page_size, AlphabetIndexMode mode, size_t line_size,
+                           Visitor&& visit, std::pmr::memory_resource* resource = DefaultResource(),
+                           PipelineStats* stats = nullptr) {
+    if (mode == AlphabetIndexMode::Words) {
+        using Words = StaticMode<AlphabetIndexMode::Words>;
+        return PaginateWith<Words>(text, page_size, mode, line_size, visit, resource, stats);
+    }
+    using Chars = StaticMode<AlphabetIndexMode::Chars>;
+    return PaginateWith<Chars>(text, page_size, mode, line_size, visit, resource, stats);
+}
+
+// Calls use(key) with the index key for `word`. Pages keep the words as
+// written; only the keys are normalized, and words that normalize to nothing
+// (bare punctuation) are left out of the index.
+template <typename Use>
+void WithIndexKey(const std::string& word, const KeyOptions& keys, Use&& use) {
+    if (!keys.strip_punctuation && !keys.fold_case) {
+        use(word);
+        return;
+    }
+    std::string key = NormalizeKey(word, keys);
+    if (!key.empty()) {
+        use(key);
+    }
+}
+
+// Backends that are immutable or slow to fill key by key declare a Staging
+// dictionary: the index is collected there and converted into Dict once the
+// whole text is indexed.
+template <typename Dict>
+struct IndexStaging {
+    using Type = Dict;
+};
+
+template <typename Dict>
+    requires requires { typename Dict::Staging; }
+struct IndexStaging<Dict> {
+    using Type = typename Dict::Staging;
+};
+
+template <typename Dict>
+std::shared_ptr<Dict> MakeIndex(std::pmr::memory_resource* resource) {
+    if constexpr (std::is_constructible_v<Dict, std::pmr::memory_resource*>) {
+        return MakeShared<Dict>(resource, resource);
+    } else {
+        return std::make_shared<Dict>();
+    }
+}
+
+template <typename Dict, typename Staging>
+IDictionaryPtr<std::string, int> FinishIndex(std::shared_ptr<Staging> staging,
+                                             std::pmr::memory_resource* resource = DefaultResource()) {
+    if constexpr (std::is_same_v<Dict, Staging>) {
+        return staging;
+    } else if constexpr (std::is_constructible_v<Dict, const Staging&, std::pmr::memory_resource*>) {
+        return MakeShared<Dict>(resource, *staging, resource);
+    } else {
+        return std::make_shared<Dict>(*staging);
+    }
+}
+
+// Builds the book allocating pages, lines and the index from `resource`.
+// Strings keep their own allocation (short words fit in the string object).
+// The index is sized up front from a distinct-word estimate of the text.
+template <typename Dict>
+Book BuildBook(const std::string& text, size_t page_size, AlphabetIndexMode mode, size_t line_size,
+               std::pmr::memory_resource* resource, KeyOptions keys = KeyOptions()) {
+    auto index = MakeIndex<typename IndexStaging<Dict>::Type>(resource);
+    index->Reserve(EstimateText(text).distinct);
+    PipelineStats stats;
+    auto pages = Paginate(
+        text, page_size, mode, line_size,
+        [&](const std::string& word, int page, int) {
+            WithIndexKey(word, keys, [&](const std::string& key) {
+                if (!index->ContainsKey(key)) {
+                    index->Add(key, page);
+                }
+            });
+        },
+        resource, &stats);
+    return Book{nullptr, std::move(pages), FinishIndex<Dict>(std::move(index), resource), nullptr, stats};
+}
+
+template <typename Dict>
+Book BuildBook(const std::string& text, size_t page_size, AlphabetIndexMode mode, size_t line_size = 0) {
+    return BuildBook<Dict>(text, page_size, mode, line_size, DefaultResource());
+}
+
+// Builds the whole book inside one monotonic arena owned by the result.
+// Nothing is freed individually; the arena is released with the book. The
+// pages, index and concordance pointers keep the arena alive, but pointers
+// to inner objects (a page's lines, say) must not outlive the book.
+template <typename Dict>
+Book BuildBookInArena(const std::string& text, size_t page_size, AlphabetIndexMode mode, size_t line_size = 0,
+                      KeyOptions keys = KeyOptions()) {
+    auto arena = std::make_shared<std::pmr::monotonic_buffer_resource>(text.size() * 4 + 4096);
+    Book book = BuildBook<Dict>(text, page_size, mode, line_size, arena.get(), keys);
+    struct Holder {
+        std::shared_ptr<std::pmr::memory_resource> arena;
+        SequencePtr<Page> pages;
+        IDictionaryPtr<std::string, int> index;
+    };
+    auto holder = std::make_shared<Holder>(Holder{arena, book.pages, book.index});
+    book.arena = arena;
+    book.pages = SequencePtr<Page>(holder, holder->pages.get());
+    book.index = IDictionaryPtr<std::string, int>(holder, holder->index.get());
+    return book;
+}
+
+// Builds the first-page index together with a full concordance: every page
+// (and optionally line) on which each word occurs.
+template <typename Dict, typename ConcordanceDict>
+Book BuildConcordanceBook(const std::string& text, size_t page_size, AlphabetIndexMode mode, size_t line_size = 0,
+                          ConcordanceOptions options = ConcordanceOptions()) {
+    auto index = std::make_shared<typename IndexStaging<Dict>::Type>();
+    auto concordance = std::make_shared<ConcordanceDict>();
+    size_t distinct = EstimateText(text).distinct;
+    index->Reserve(distinct);
+    concordance->Reserve(distinct);
+    PipelineStats stats;
+    auto pages = Paginate(
+        text, page_size, mode, line_size,
+        [&](const std::string& word, int page, int line) {
+            WithIndexKey(word, options.keys, [&](const std::string& key) {
+                if (!concordance->ContainsKey(key)) {
+                    concordance->Add(key, std::make_shared<PostingList>(options.with_lines));
+                    index->Add(key, page);
+                }
+                concordance->Get(key)->Add(page, line);
+            });
+        },
+        DefaultResource(), &stats);
+    return Book{nullptr, std::move(pages), FinishIndex<Dict>(std::move(index)), std::move(concordance), stats};
 }
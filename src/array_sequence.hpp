@@ -1,7 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <memory>
 #include <stdexcept>
 
+#include "bounds_check.hpp"
 #include "dynamic_array.hpp"
 #include "sequence.hpp"
 
@@ -45,37 +48,35 @@ private:
     size_t index_ = 0;
 };
 
+// Contiguous sequence over a reference-counted buffer. Copies and slices
+// (GetSubsequence, GetFirst/GetLast(count), Slice) share the buffer, so they
+// cost O(1) and stay valid after the source is gone; the first write to a
+// shared buffer copies the elements out (copy-on-write). Pointers from
+// GetBegin() are invalidated by any later write.
 template <typename T>
 class ArraySequence : public Sequence<T> {
+    using Buffer = DynamicArray<T>;
+
 public:
-    ArraySequence(const T* items, size_t count) {
-        if (count == 0) {
-            capacity_ = 1;
-            size_ = 0;
-            data_ = DynamicArray<T>(capacity_);
-        } else {
-            capacity_ = count;
-            size_ = count;
-            data_ = DynamicArray<T>(items, count);
-        }
+    ArraySequence(const T* items, size_t count, std::pmr::memory_resource* resource = DefaultResource())
+        : capacity_(count == 0 ? 1 : count),
+          size_(count),
+          buffer_(count == 0 ? MakeShared<Buffer>(resource, capacity_, resource)
+                             : MakeShared<Buffer>(resource, items, count, resource)) {
     }
 
-    ArraySequence(size_t count) {
-        if (count == 0) {
-            capacity_ = 1;
-            size_ = 0;
-            data_ = DynamicArray<T>(capacity_);
-        } else {
-            capacity_ = count;
-            size_ = count;
-            data_ = DynamicArray<T>(count);
-        }
+    ArraySequence(size_t count, std::pmr::memory_resource* resource = DefaultResource())
+        : capacity_(count == 0 ? 1 : count), size_(count), buffer_(MakeShared<Buffer>(resource, capacity_, resource)) {
     }
 
-    ArraySequence(DynamicArray<T> a) : capacity_(a.GetSize()), size_(a.GetSize()), data_(std::move(a)) {
+    ArraySequence(DynamicArray<T> a)
+        : capacity_(a.GetSize()), size_(a.GetSize()), buffer_(MakeShared<Buffer>(a.GetResource(), std::move(a))) {
     }
 
-    ArraySequence(const Sequence<T>& a) : capacity_(a.GetCapacity()), size_(0), data_(capacity_) {
+    ArraySequence(const Sequence<T>& a, std::pmr::memory_resource* resource = DefaultResource())
+        : capacity_(a.GetCapacity() == 0 ? 1 : a.GetCapacity()),
+          size_(0),
+          buffer_(MakeShared<Buffer>(resource, capacity_, resource)) {
         for (IIteratorPtr<T> it = a.GetIterator(); it->HasNext(); it->Next()) {
             Append(it->GetCurrentItem());
         }
@@ -84,35 +85,41 @@ public:
     ArraySequence(SequencePtr<T> a) : ArraySequence(*a) {
     }
 
-    ArraySequence() : capacity_(1), size_(0), data_(capacity_) {
+    explicit ArraySequence(std::pmr::memory_resource* resource)
+        : capacity_(1), size_(0), buffer_(MakeShared<Buffer>(resource, capacity_, resource)) {
+    }
+
+    ArraySequence() : ArraySequence(DefaultResource()) {
     }
 
     const T& GetFirst() const override {
         if (size_ == 0) {
             throw std::out_of_range("Sequence is empty");
         }
-        return data_.Get(0);
+        return Data()[0];
     }
 
     const T& GetLast() const override {
         if (size_ == 0) {
             throw std::out_of_range("Sequence is empty");
         }
-        return data_.Get(size_ - 1);
+        return Data()[size_ - 1];
     }
 
     const T& Get(size_t index) const override {
-        if (index >= size_) {
-            throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
-        }
-        return data_.Get(index);
+        CheckIndex(index, size_);
+        return Data()[index];
+    }
+
+    // Unchecked access for indices that are valid by construction.
+    const T& operator[](size_t index) const {
+        CheckIndexIfEnabled(index, size_);
+        return Data()[index];
     }
 
     void Set(const T& item, size_t index) override {
-        if (index >= size_) {
-            throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
-        }
-        data_.Set(item, index);
+        CheckIndex(index, size_);
+        MutableData()[index] = item;
     }
 
     SequencePtr<T> GetSubsequence(size_t startIndex, size_t endIndex) const override {
@@ -123,9 +130,7 @@ public:
         if (startIndex > endIndex) {
             throw std::out_of_range("startIndex is greater than endIndex");
         }
-        const T* start = data_.GetBegin() + startIndex;
-        size_t sz = endIndex - startIndex + 1;
-        return std::make_shared<ArraySequence<T>>(start, sz);
+        return std::make_shared<ArraySequence<T>>(Slice(startIndex, endIndex + 1));
     }
 
     SequencePtr<T> GetFirst(size_t count) const override {
@@ -148,6 +153,19 @@ public:
         return GetSubsequence(size_ - count, size_ - 1);
     }
 
+    // Elements [begin, end) sharing this sequence's buffer.
+    ArraySequence<T> Slice(size_t begin, size_t end) const {
+        if (begin > end || end > size_) {
+            throw std::out_of_range("Index is out of range: " + std::to_string(begin) + " " + std::to_string(end) +
+                                    " " + std::to_string(size_));
+        }
+        ArraySequence<T> slice(*this);
+        slice.offset_ += begin;
+        slice.size_ = end - begin;
+        slice.capacity_ = end - begin;
+        return slice;
+    }
+
     size_t GetLength() const override {
         return size_;
     }
@@ -156,6 +174,12 @@ public:
         return capacity_;
     }
 
+    void Reserve(size_t capacity) override {
+        if (capacity > capacity_) {
+            Reallocate(capacity);
+        }
+    }
+
     void Append(const T& item) override {
         PushBack(item);
     }
@@ -169,12 +193,9 @@ public:
     }
 
     void EraseAt(size_t index) override {
-        if (index >= size_) {
-            throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
-        }
-        for (size_t i = index; i + 1 < size_; ++i) {
-            data_.Set(data_.Get(i + 1), i);
-        }
+        CheckIndex(index, size_);
+        T* data = MutableData();
+        MoveElements(data + index + 1, size_ - index - 1, data + index);
         --size_;
     }
 
@@ -182,36 +203,79 @@ public:
         size_ = 0;
     }
 
+    const T* GetBegin() const {
+        return Data();
+    }
+
+    T* GetBegin() {
+        return MutableData();
+    }
+
     IIteratorPtr<T> GetIterator() const override {
-        return std::make_shared<ArraySequenceIterator<T>>(data_.GetBegin(), size_);
+        return std::make_shared<ArraySequenceIterator<T>>(Data(), size_);
+    }
+
+    // Iterates over [begin, end) without copying the elements.
+    IIteratorPtr<T> GetRangeIterator(size_t begin, size_t end) const {
+        if (begin > end || end > size_) {
+            throw std::out_of_range("Index is out of range: " + std::to_string(begin) + " " + std::to_string(end) +
+                                    " " + std::to_string(size_));
+        }
+        return std::make_shared<ArraySequenceIterator<T>>(Data() + begin, end - begin);
     }
 
 private:
-    size_t capacity_;
+    size_t capacity_;  // elements available from offset_
     size_t size_;
-    DynamicArray<T> data_;
+    size_t offset_ = 0;
+    std::shared_ptr<Buffer> buffer_;
+
+    const T* Data() const {
+        return buffer_->GetBegin() + offset_;
+    }
+
+    T* MutableData() {
+        if (buffer_.use_count() > 1) {
+            Reallocate(capacity_);
+        }
+        return buffer_->GetBegin() + offset_;
+    }
+
+    // Moves the elements to a fresh buffer of `capacity` at offset 0; they are
+    // copied instead while the old buffer is shared.
+    void Reallocate(size_t capacity) {
+        auto resource = buffer_->GetResource();
+        auto fresh = MakeShared<Buffer>(resource, capacity, resource);
+        T* from = buffer_->GetBegin() + offset_;
+        T* to = fresh->GetBegin();
+        if (buffer_.use_count() > 1) {
+            std::copy(from, from + size_, to);
+        } else {
+            std::move(from, from + size_, to);
+        }
+        buffer_ = std::move(fresh);
+        offset_ = 0;
+        capacity_ = capacity;
+    }
 
     void PushBack(const T& item) {
         if (size_ == capacity_) {
-            capacity_ *= 2;
-            data_.Resize(capacity_);
+            Reallocate(capacity_ == 0 ? 1 : capacity_ * 2);
         }
-        data_.Set(item, size_);
+        MutableData()[size_] = item;
         ++size_;
     }
 
     void Insert(const T& item, size_t index) {
         if (index > size_) {
-            throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
+            ThrowIndexOutOfRange(index, size_);
         }
         if (size_ == capacity_) {
-            data_.Resize(capacity_ * 2);
-            capacity_ *= 2;
-        }
-        for (size_t i = size_; i > index; --i) {
-            data_.Set(data_.Get(i - 1), i);
+            Reallocate(capacity_ == 0 ? 1 : capacity_ * 2);
         }
-        data_.Set(item, index);
+        T* data = MutableData();
+        MoveElements(data + index, size_ - index, data + index + 1);
+        data[index] = item;
         ++size_;
     }
 };
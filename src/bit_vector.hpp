@@ -0,0 +1,106 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "array_sequence.hpp"
+#include "bounds_check.hpp"
+
+// Append-only bit vector with rank/select support. Build() must be called
+// after the last PushBack and before any Rank1/Select0 query.
+class BitVector {
+    static constexpr size_t kWordBits = 64;
+    static constexpr size_t kWordsPerBlock = 8;
+
+public:
+    void PushBack(bool bit) {
+        if (size_ % kWordBits == 0) {
+            words_.Append(0);
+        }
+        if (bit) {
+            size_t w = size_ / kWordBits;
+            words_.Set(words_[w] | (uint64_t{1} << (size_ % kWordBits)), w);
+        }
+        ++size_;
+    }
+
+    void Build() {
+        ranks_.Clear();
+        uint64_t ones = 0;
+        for (size_t w = 0; w < words_.GetLength(); ++w) {
+            if (w % kWordsPerBlock == 0) {
+                ranks_.Append(ones);
+            }
+            ones += std::popcount(words_[w]);
+        }
+        ranks_.Append(ones);
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+    size_t GetByteSize() const {
+        return words_.GetLength() * sizeof(uint64_t) + ranks_.GetLength() * sizeof(uint64_t);
+    }
+
+    bool Get(size_t index) const {
+        CheckIndex(index, size_);
+        return (words_[index / kWordBits] >> (index % kWordBits)) & 1;
+    }
+
+    // Number of set bits in [0, index).
+    size_t Rank1(size_t index) const {
+        size_t w = index / kWordBits;
+        size_t res = ranks_[w / kWordsPerBlock];
+        for (size_t i = w - w % kWordsPerBlock; i < w; ++i) {
+            res += std::popcount(words_[i]);
+        }
+        if (index % kWordBits != 0) {
+            res += std::popcount(words_[w] & ((uint64_t{1} << (index % kWordBits)) - 1));
+        }
+        return res;
+    }
+
+    size_t Rank0(size_t index) const {
+        return index - Rank1(index);
+    }
+
+    // Position of the zero bit with zero-based rank k.
+    size_t Select0(size_t k) const {
+        size_t l = 0;
+        size_t r = ranks_.GetLength() - 1;
+        while (l + 1 < r) {
+            size_t mid = (l + r) / 2;
+            if (mid * kWordsPerBlock * kWordBits - ranks_[mid] <= k) {
+                l = mid;
+            } else {
+                r = mid;
+            }
+        }
+        size_t zeros = l * kWordsPerBlock * kWordBits - ranks_[l];
+        for (size_t w = l * kWordsPerBlock; w < words_.GetLength(); ++w) {
+            uint64_t inverted = ~words_[w];
+            size_t count = std::popcount(inverted);
+            if (zeros + count > k) {
+                for (size_t skip = k - zeros; skip > 0; --skip) {
+                    inverted &= inverted - 1;
+                }
+                size_t pos = w * kWordBits + std::countr_zero(inverted);
+                if (pos >= size_) {
+                    break;
+                }
+                return pos;
+            }
+            zeros += count;
+        }
+        throw std::out_of_range("No such zero bit: " + std::to_string(k));
+    }
+
+private:
+    ArraySequence<uint64_t> words_;
+    ArraySequence<uint64_t> ranks_;
+    size_t size_ = 0;
+};
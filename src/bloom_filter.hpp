@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "dynamic_array.hpp"
+
+// Split-block Bloom filter: every key sets one bit in each of the eight
+// 32-bit words of a single 256-bit block, so an insert or a query touches
+// one cache line. At ten bits per key the false-positive rate is about 1%.
+// Keys are given by a well-mixed 64-bit hash: the high half picks the
+// block, the low half the bits inside it.
+class BlockedBloomFilter {
+public:
+    static constexpr size_t kBitsPerKey = 10;
+    static constexpr size_t kBlockWords = 8;
+
+    explicit BlockedBloomFilter(size_t expected_keys)
+        : blocks_((expected_keys * kBitsPerKey) / (32 * kBlockWords) + 1), words_(blocks_ * kBlockWords) {
+        std::memset(words_.GetBegin(), 0, words_.GetSize() * sizeof(uint32_t));
+    }
+
+    void Add(uint64_t hash) {
+        uint32_t* block = words_.GetBegin() + Block(hash) * kBlockWords;
+        const auto low = static_cast<uint32_t>(hash);
+        for (size_t i = 0; i < kBlockWords; ++i) {
+            block[i] |= Mask(low, i);
+        }
+    }
+
+    bool MayContain(uint64_t hash) const {
+        const uint32_t* block = words_.GetBegin() + Block(hash) * kBlockWords;
+        const auto low = static_cast<uint32_t>(hash);
+        for (size_t i = 0; i < kBlockWords; ++i) {
+            if ((block[i] & Mask(low, i)) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t GetByteSize() const {
+        return words_.GetSize() * sizeof(uint32_t);
+    }
+
+private:
+    // Odd multipliers, one per word, from the Parquet split-block filter.
+    static constexpr uint32_t kSalt[kBlockWords] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                                    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+    size_t Block(uint64_t hash) const {
+        return static_cast<size_t>(((hash >> 32) * blocks_) >> 32);
+    }
+
+    static uint32_t Mask(uint32_t low, size_t word) {
+        return uint32_t{1} << ((low * kSalt[word]) >> 27);
+    }
+
+    size_t blocks_;
+    DynamicArray<uint32_t> words_;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+// Index checks. Public accessors (Get, Set, InsertAt, EraseAt) always check.
+// Containers also offer an unchecked operator[] for internal loops whose
+// indices are valid by construction; it checks only when LAB2_CHECKED_ACCESS
+// is defined (CMake option LAB2_CHECKED_ACCESS, on for Debug builds).
+#ifdef LAB2_CHECKED_ACCESS
+inline constexpr bool kCheckedAccess = true;
+#else
+inline constexpr bool kCheckedAccess = false;
+#endif
+
+// Kept out of line so that the message formatting does not bloat the
+// accessors that check.
+[[noreturn, gnu::cold, gnu::noinline]] inline void ThrowIndexOutOfRange(size_t index, size_t size) {
+    throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size));
+}
+
+inline void CheckIndex(size_t index, size_t size) {
+    if (index >= size) [[unlikely]] {
+        ThrowIndexOutOfRange(index, size);
+    }
+}
+
+// The check behind the unchecked accessors.
+inline void CheckIndexIfEnabled([[maybe_unused]] size_t index, [[maybe_unused]] size_t size) {
+    if constexpr (kCheckedAccess) {
+        CheckIndex(index, size);
+    }
+}
@@ -0,0 +1,513 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+
+#include "array_sequence.hpp"
+#include "hash_table.hpp"
+#include "isorted_dictionary.hpp"
+#include "parallel_sort.hpp"
+#include "sequence_view.hpp"
+#include "stats.hpp"
+
+// B+tree over ordered keys. Entries live in the leaves, which are linked in
+// key order for iteration and range scans; inner nodes hold separator keys
+// only. Nodes are sized to about four cache lines of keys, so a lookup
+// touches a handful of nodes and an insert shifts at most one node's worth
+// of entries, unlike FlatTable, which shifts the whole tail of its array.
+//
+// Deletion is relaxed: nodes may run underfull and are never merged. A leaf
+// that becomes empty is unlinked and dropped from its parent, and a root
+// left with a single child is replaced by that child, so the only node that
+// can be empty is a root leaf.
+template <typename Key, typename Value>
+class BPlusTree : public ISortedDictionary<Key, Value>, public std::enable_shared_from_this<BPlusTree<Key, Value>> {
+    using Pair = KeyValue<Key, Value>;
+
+    static constexpr size_t kNodeBytes = 256;
+    static constexpr size_t kMinNodeSize = 4;
+    static constexpr size_t kLeafSize =
+        kNodeBytes / sizeof(Pair) < kMinNodeSize ? kMinNodeSize : kNodeBytes / sizeof(Pair);
+    // Children per inner node; it holds one key fewer.
+    static constexpr size_t kFanout = kNodeBytes / sizeof(Key) < kMinNodeSize ? kMinNodeSize : kNodeBytes / sizeof(Key);
+
+    struct Node {
+        explicit Node(bool is_leaf) : leaf(is_leaf) {
+        }
+
+        bool leaf;
+        size_t count = 0;  // entries in a leaf, children in an inner node
+    };
+
+    struct Leaf : Node {
+        Leaf() : Node(true) {
+        }
+
+        Pair entries[kLeafSize];
+        Leaf* prev = nullptr;
+        Leaf* next = nullptr;
+    };
+
+    struct Inner : Node {
+        Inner() : Node(false) {
+        }
+
+        Key keys[kFanout - 1];
+        Node* children[kFanout] = {};
+    };
+
+    struct Split {
+        Key separator;
+        Node* right = nullptr;
+    };
+
+    class Iterator : public IIterator<Pair> {
+    public:
+        Iterator(const Leaf* leaf, size_t index, const Key* hi) : leaf_(leaf), index_(index), has_hi_(hi != nullptr) {
+            if (has_hi_) {
+                hi_ = *hi;
+            }
+            if (leaf_ != nullptr && index_ == leaf_->count) {
+                leaf_ = leaf_->next;
+                index_ = 0;
+            }
+        }
+
+        bool HasNext() const override {
+            return leaf_ != nullptr && index_ < leaf_->count && (!has_hi_ || leaf_->entries[index_].key < hi_);
+        }
+
+        bool Next() override {
+            if (!HasNext()) {
+                return false;
+            }
+            if (++index_ == leaf_->count) {
+                leaf_ = leaf_->next;
+                index_ = 0;
+            }
+            return true;
+        }
+
+        const Pair& GetCurrentItem() const override {
+            if (!HasNext()) {
+                throw std::out_of_range("No next element");
+            }
+            return leaf_->entries[index_];
+        }
+
+        bool TryGetCurrentItem(Pair& element) const override {
+            if (!HasNext()) {
+                return false;
+            }
+            element = leaf_->entries[index_];
+            return true;
+        }
+
+    private:
+        const Leaf* leaf_;
+        size_t index_;
+        bool has_hi_;
+        Key hi_;
+    };
+
+public:
+    // BuildBook mostly probes for words it has already seen, which a hash
+    // table answers faster; the tree is then bulk-loaded from it.
+    using Staging = HashTable<Key, Value>;
+
+    BPlusTree() : root_(new Leaf()), head_(static_cast<Leaf*>(root_)), leaves_(1) {
+    }
+
+    // Bulk load: the entries are sorted (if they are not already) and packed
+    // into full leaves, then each inner level is built over the one below.
+    explicit BPlusTree(const IDictionary<Key, Value>& source) {
+        ArraySequence<Pair> pairs(source.GetCount());
+        size_t i = 0;
+        bool sorted = true;
+        for (auto it = source.GetIterator(); it->HasNext(); it->Next(), ++i) {
+            pairs.Set(it->GetCurrentItem(), i);
+            if (i > 0 && !(pairs[i - 1].key < pairs[i].key)) {
+                sorted = false;
+            }
+        }
+        if (!sorted) {
+            ParallelMergeSort(pairs.GetBegin(), pairs.GetLength(), KeyLess<Key, Value>());
+        }
+        BulkLoad(pairs.GetBegin(), pairs.GetLength());
+    }
+
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+
+    ~BPlusTree() override {
+        Destroy(root_);
+    }
+
+    size_t GetCount() const override {
+        return size_;
+    }
+
+    size_t GetCapacity() const override {
+        return leaves_ * kLeafSize;
+    }
+
+    size_t GetHeight() const {
+        size_t height = 1;
+        for (const Node* node = root_; !node->leaf; node = static_cast<const Inner*>(node)->children[0]) {
+            ++height;
+        }
+        return height;
+    }
+
+    const Value& Get(const Key& key) const override {
+        const Leaf* leaf = FindLeaf(key);
+        size_t pos = LowerBound(*leaf, key);
+        if (pos == leaf->count || leaf->entries[pos].key != key) {
+            throw std::out_of_range("No such key");
+        }
+        return leaf->entries[pos].value;
+    }
+
+    bool ContainsKey(const Key& key) const override {
+        const Leaf* leaf = FindLeaf(key);
+        size_t pos = LowerBound(*leaf, key);
+        return pos < leaf->count && leaf->entries[pos].key == key;
+    }
+
+    void Add(const Key& key, const Value& value) override {
+        LAB2_STAT(++stats_.lookups);
+        Split split;
+        if (Insert(root_, key, value, split)) {
+            ++size_;
+        }
+        if (split.right != nullptr) {
+            auto* root = new Inner();
+            root->keys[0] = std::move(split.separator);
+            root->children[0] = root_;
+            root->children[1] = split.right;
+            root->count = 2;
+            root_ = root;
+        }
+    }
+
+    void Remove(const Key& key) override {
+        LAB2_STAT(++stats_.lookups);
+        if (Erase(root_, key)) {
+            // Only the root leaf may stay empty; Erase leaves it in place.
+            return;
+        }
+        while (!root_->leaf && root_->count == 1) {
+            auto* old = static_cast<Inner*>(root_);
+            root_ = old->children[0];
+            delete old;
+        }
+    }
+
+    SequencePtr<Key> GetKeys() const override {
+        return std::make_shared<KeysView<Key, Value>>(ShareOrBorrow(*this));
+    }
+
+    SequencePtr<Value> GetValues() const override {
+        return std::make_shared<ValuesView<Key, Value>>(ShareOrBorrow(*this));
+    }
+
+    IIteratorPtr<Pair> GetIterator() const override {
+        return std::make_shared<Iterator>(head_, 0, nullptr);
+    }
+
+    IIteratorPtr<Pair> Range(const Key& lo, const Key& hi) const override {
+        const Leaf* leaf = FindLeaf(lo);
+        return std::make_shared<Iterator>(leaf, LowerBound(*leaf, lo), &hi);
+    }
+
+    IIteratorPtr<Pair> RangeFrom(const Key& lo) const override {
+        const Leaf* leaf = FindLeaf(lo);
+        return std::make_shared<Iterator>(leaf, LowerBound(*leaf, lo), nullptr);
+    }
+
+    // Lookups, nodes visited and key comparisons.
+    LookupStats GetStats() const {
+#ifdef LAB2_STATS
+        return stats_;
+#else
+        return LookupStats{};
+#endif
+    }
+
+    void ResetStats() {
+#ifdef LAB2_STATS
+        stats_ = LookupStats{};
+#endif
+    }
+
+private:
+    // First child whose range can hold `key`: the number of separators <= key.
+    size_t ChildIndex(const Inner& inner, const Key& key) const {
+        size_t lo = 0;
+        size_t hi = inner.count - 1;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            LAB2_STAT(++stats_.comparisons);
+            if (key < inner.keys[mid]) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        return lo;
+    }
+
+    size_t LowerBound(const Leaf& leaf, const Key& key) const {
+        size_t lo = 0;
+        size_t hi = leaf.count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            LAB2_STAT(++stats_.comparisons);
+            if (leaf.entries[mid].key < key) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    const Leaf* FindLeaf(const Key& key) const {
+        LAB2_STAT(++stats_.lookups);
+        const Node* node = root_;
+        while (!node->leaf) {
+            LAB2_STAT(++stats_.probes);
+            const auto* inner = static_cast<const Inner*>(node);
+            node = inner->children[ChildIndex(*inner, key)];
+        }
+        LAB2_STAT(++stats_.probes);
+        return static_cast<const Leaf*>(node);
+    }
+
+    // Inserts or updates `key` below `node`; returns whether the key is new.
+    // If `node` had to split, the new right sibling and the first key of its
+    // range are left in `split`.
+    bool Insert(Node* node, const Key& key, const Value& value, Split& split) {
+        LAB2_STAT(++stats_.probes);
+        if (node->leaf) {
+            auto* leaf = static_cast<Leaf*>(node);
+            size_t pos = LowerBound(*leaf, key);
+            if (pos < leaf->count && leaf->entries[pos].key == key) {
+                leaf->entries[pos].value = value;
+                return false;
+            }
+            if (leaf->count == kLeafSize) {
+                Leaf* right = SplitLeaf(leaf);
+                split.separator = right->entries[0].key;
+                split.right = right;
+                if (pos > leaf->count) {
+                    pos -= leaf->count;
+                    leaf = right;
+                }
+            }
+            for (size_t i = leaf->count; i > pos; --i) {
+                leaf->entries[i] = std::move(leaf->entries[i - 1]);
+            }
+            leaf->entries[pos] = Pair(key, value);
+            ++leaf->count;
+            return true;
+        }
+
+        auto* inner = static_cast<Inner*>(node);
+        size_t index = ChildIndex(*inner, key);
+        Split child;
+        bool inserted = Insert(inner->children[index], key, value, child);
+        if (child.right == nullptr) {
+            return inserted;
+        }
+        if (inner->count == kFanout) {
+            Inner* right = SplitInner(inner, split.separator);
+            split.right = right;
+            if (index >= inner->count) {
+                index -= inner->count;
+                inner = right;
+            }
+        }
+        for (size_t i = inner->count - 1; i > index; --i) {
+            inner->keys[i] = std::move(inner->keys[i - 1]);
+            inner->children[i + 1] = inner->children[i];
+        }
+        inner->keys[index] = std::move(child.separator);
+        inner->children[index + 1] = child.right;
+        ++inner->count;
+        return inserted;
+    }
+
+    // Moves the upper half of a full leaf into a new right sibling.
+    Leaf* SplitLeaf(Leaf* leaf) {
+        auto* right = new Leaf();
+        size_t keep = kLeafSize / 2;
+        for (size_t i = keep; i < kLeafSize; ++i) {
+            right->entries[i - keep] = std::move(leaf->entries[i]);
+        }
+        right->count = kLeafSize - keep;
+        leaf->count = keep;
+        right->next = leaf->next;
+        right->prev = leaf;
+        if (leaf->next != nullptr) {
+            leaf->next->prev = right;
+        }
+        leaf->next = right;
+        ++leaves_;
+        return right;
+    }
+
+    // Moves the upper half of a full inner node into a new right sibling;
+    // the key between the halves goes up into `separator`.
+    Inner* SplitInner(Inner* inner, Key& separator) {
+        auto* right = new Inner();
+        size_t keep = kFanout / 2;
+        separator = std::move(inner->keys[keep - 1]);
+        for (size_t i = keep; i < kFanout; ++i) {
+            right->children[i - keep] = inner->children[i];
+            inner->children[i] = nullptr;
+            if (i < kFanout - 1) {
+                right->keys[i - keep] = std::move(inner->keys[i]);
+            }
+        }
+        right->count = kFanout - keep;
+        inner->count = keep;
+        return right;
+    }
+
+    // Removes `key` below `node`; returns whether `node` is now empty and
+    // has been unlinked, for the caller to drop. The root is never dropped.
+    bool Erase(Node* node, const Key& key) {
+        LAB2_STAT(++stats_.probes);
+        if (node->leaf) {
+            auto* leaf = static_cast<Leaf*>(node);
+            size_t pos = LowerBound(*leaf, key);
+            if (pos == leaf->count || leaf->entries[pos].key != key) {
+                throw std::out_of_range("No such key");
+            }
+            for (size_t i = pos + 1; i < leaf->count; ++i) {
+                leaf->entries[i - 1] = std::move(leaf->entries[i]);
+            }
+            leaf->entries[--leaf->count] = Pair();
+            --size_;
+            if (leaf->count > 0 || node == root_) {
+                return false;
+            }
+            if (leaf->prev != nullptr) {
+                leaf->prev->next = leaf->next;
+            } else {
+                head_ = leaf->next;
+            }
+            if (leaf->next != nullptr) {
+                leaf->next->prev = leaf->prev;
+            }
+            --leaves_;
+            return true;
+        }
+
+        auto* inner = static_cast<Inner*>(node);
+        size_t index = ChildIndex(*inner, key);
+        if (!Erase(inner->children[index], key)) {
+            return false;
+        }
+        Destroy(inner->children[index]);
+        // Drop the child with the separator on its left (or, for the first
+        // child, on its right).
+        size_t key_index = index == 0 ? 0 : index - 1;
+        for (size_t i = key_index + 1; i + 1 < inner->count; ++i) {
+            inner->keys[i - 1] = std::move(inner->keys[i]);
+        }
+        for (size_t i = index + 1; i < inner->count; ++i) {
+            inner->children[i - 1] = inner->children[i];
+        }
+        --inner->count;
+        inner->children[inner->count] = nullptr;
+        if (inner->count > 0) {
+            inner->keys[inner->count - 1] = Key();
+        }
+        if (inner->count > 0 || node == root_) {
+            if (inner->count == 0) {
+                // The root lost its last child: start over with an empty leaf.
+                delete inner;
+                root_ = head_ = new Leaf();
+                leaves_ = 1;
+                return true;
+            }
+            return false;
+        }
+        return true;
+    }
+
+    void BulkLoad(const Pair* items, size_t count) {
+        ArraySequence<Node*> level;
+        ArraySequence<Key> firsts;
+        Leaf* prev = nullptr;
+        for (size_t begin = 0; begin < count || level.GetLength() == 0; begin += kLeafSize) {
+            auto* leaf = new Leaf();
+            size_t end = begin + kLeafSize < count ? begin + kLeafSize : count;
+            for (size_t i = begin; i < end; ++i) {
+                leaf->entries[i - begin] = items[i];
+            }
+            leaf->count = end - begin;
+            leaf->prev = prev;
+            if (prev != nullptr) {
+                prev->next = leaf;
+            }
+            prev = leaf;
+            level.Append(leaf);
+            firsts.Append(begin < count ? items[begin].key : Key());
+        }
+        head_ = static_cast<Leaf*>(level[0]);
+        leaves_ = level.GetLength();
+        size_ = count;
+
+        while (level.GetLength() > 1) {
+            ArraySequence<Node*> parents;
+            ArraySequence<Key> parent_firsts;
+            // Children are spread evenly, so no inner node ends up with a
+            // single child.
+            const size_t total = level.GetLength();
+            const size_t groups = (total + kFanout - 1) / kFanout;
+            for (size_t g = 0, begin = 0; g < groups; ++g) {
+                size_t end = begin + total / groups + (g < total % groups ? 1 : 0);
+                auto* inner = new Inner();
+                for (size_t i = begin; i < end; ++i) {
+                    if (i > begin) {
+                        inner->keys[i - begin - 1] = firsts[i];
+                    }
+                    inner->children[i - begin] = level[i];
+                }
+                inner->count = end - begin;
+                parents.Append(inner);
+                parent_firsts.Append(firsts[begin]);
+                begin = end;
+            }
+            level = std::move(parents);
+            firsts = std::move(parent_firsts);
+        }
+        root_ = level[0];
+    }
+
+    static void Destroy(Node* node) {
+        if (node == nullptr) {
+            return;
+        }
+        if (!node->leaf) {
+            auto* inner = static_cast<Inner*>(node);
+            for (size_t i = 0; i < inner->count; ++i) {
+                Destroy(inner->children[i]);
+            }
+            delete inner;
+        } else {
+            delete static_cast<Leaf*>(node);
+        }
+    }
+
+    Node* root_ = nullptr;
+    Leaf* head_ = nullptr;
+    size_t size_ = 0;
+    size_t leaves_ = 0;
+#ifdef LAB2_STATS
+    mutable LookupStats stats_;
+#endif
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#include "dynamic_array.hpp"
+
+// Formats output into a large reusable buffer and hands it to the stream in
+// big write() calls. Integers are formatted with std::to_chars, so the bytes
+// are the same as with operator<< on a default-formatted stream.
+//
+// In async mode a background thread writes one buffer while the caller fills
+// the other, overlapping formatting with the stream I/O.
+class BufferedWriter {
+public:
+    static constexpr size_t kDefaultCapacity = 1 << 16;
+
+    explicit BufferedWriter(std::ostream& out, size_t capacity = kDefaultCapacity, bool async = false)
+        : out_(out), fill_(capacity == 0 ? 1 : capacity), spare_(async ? fill_.GetSize() : 0) {
+        if (async) {
+            thread_ = std::thread([this] { WriterLoop(); });
+        }
+    }
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    ~BufferedWriter() {
+        Flush();
+        if (thread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            thread_.join();
+        }
+    }
+
+    void Write(const char* data, size_t size) {
+        while (size > 0) {
+            if (used_ == fill_.GetSize()) {
+                HandOff();
+            }
+            size_t chunk = fill_.GetSize() - used_;
+            if (chunk > size) {
+                chunk = size;
+            }
+            std::memcpy(fill_.GetBegin() + used_, data, chunk);
+            used_ += chunk;
+            data += chunk;
+            size -= chunk;
+        }
+    }
+
+    void Put(char ch) {
+        if (used_ == fill_.GetSize()) {
+            HandOff();
+        }
+        fill_.GetBegin()[used_++] = ch;
+    }
+
+    template <typename Int>
+        requires std::is_integral_v<Int>
+    void WriteInt(Int value) {
+        char digits[24];
+        auto res = std::to_chars(digits, digits + sizeof(digits), value);
+        Write(digits, res.ptr - digits);
+    }
+
+    // Writes out everything buffered so far and waits until the stream has it.
+    void Flush() {
+        HandOff();
+        if (thread_.joinable()) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return pending_ == 0; });
+        }
+        out_.flush();
+    }
+
+    BufferedWriter& operator<<(std::string_view text) {
+        Write(text.data(), text.size());
+        return *this;
+    }
+
+    BufferedWriter& operator<<(const char* text) {
+        return *this << std::string_view(text);
+    }
+
+    BufferedWriter& operator<<(const std::string& text) {
+        return *this << std::string_view(text);
+    }
+
+    BufferedWriter& operator<<(char ch) {
+        Put(ch);
+        return *this;
+    }
+
+    template <typename Int>
+        requires(std::is_integral_v<Int> && !std::is_same_v<Int, char> && !std::is_same_v<Int, bool>)
+    BufferedWriter& operator<<(Int value) {
+        WriteInt(value);
+        return *this;
+    }
+
+private:
+    void HandOff() {
+        if (used_ == 0) {
+            return;
+        }
+        if (!thread_.joinable()) {
+            out_.write(fill_.GetBegin(), used_);
+            used_ = 0;
+            return;
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return pending_ == 0; });
+            std::swap(fill_, spare_);
+            pending_ = used_;
+        }
+        cv_.notify_all();
+        used_ = 0;
+    }
+
+    void WriterLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this] { return pending_ != 0 || stop_; });
+            if (pending_ == 0) {
+                return;
+            }
+            // The producer only touches spare_ under the lock after pending_
+            // drops to zero, so the write can run unlocked.
+            lock.unlock();
+            out_.write(spare_.GetBegin(), pending_);
+            lock.lock();
+            pending_ = 0;
+            cv_.notify_all();
+        }
+    }
+
+    std::ostream& out_;
+    DynamicArray<char> fill_;
+    DynamicArray<char> spare_;
+    size_t used_ = 0;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t pending_ = 0;
+    bool stop_ = false;
+};
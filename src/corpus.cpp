@@ -0,0 +1,202 @@
+#include "corpus.hpp"
+
+#include <cmath>
+#include <functional>
+#include <sstream>
+
+#include "array_sequence.hpp"
+#include "hash_table.hpp"
+#include "sorted_sequence.hpp"
+
+namespace {
+
+// Relative frequencies of English letters and word lengths (1..15).
+const int kLetterWeights[26] = {82, 15, 28, 43, 127, 22, 20, 61, 70, 2, 8, 40, 24,
+                                67, 75, 19, 1,  60, 63,  91, 28, 10, 24, 2, 20, 1};
+const int kLengthWeights[15] = {3, 17, 20, 16, 11, 9, 8, 6, 4, 3, 2, 1, 1, 1, 1};
+const int kLetterTotal = 1003;
+
+// Draws an index with probability proportional to weights[i].
+size_t Pick(SplitMix64& rng, const int* weights, size_t size, int total) {
+    int r = static_cast<int>(rng.Next() % static_cast<uint64_t>(total));
+    for (size_t i = 0; i < size; ++i) {
+        if (r < weights[i]) {
+            return i;
+        }
+        r -= weights[i];
+    }
+    return size - 1;
+}
+
+// Letter draws dominate vocabulary generation (the Collide filter throws
+// away thousands of words per kept one), so they use a lookup table.
+struct LetterTable {
+    char letters[kLetterTotal];
+
+    LetterTable() {
+        size_t pos = 0;
+        for (int i = 0; i < 26; ++i) {
+            for (int j = 0; j < kLetterWeights[i]; ++j) {
+                letters[pos++] = static_cast<char>('a' + i);
+            }
+        }
+    }
+};
+
+char RandomLetter(SplitMix64& rng) {
+    static const LetterTable table;
+    return table.letters[rng.Next() % kLetterTotal];
+}
+
+// Replaces everything after `keep` bytes of `word` with a random word.
+void RandomWord(SplitMix64& rng, size_t max_length, size_t keep, std::string& word) {
+    size_t limit = max_length == 0 ? 1 : (max_length < 15 ? max_length : 15);
+    int total = 0;
+    for (size_t i = 0; i < limit; ++i) {
+        total += kLengthWeights[i];
+    }
+    size_t length = 1 + Pick(rng, kLengthWeights, limit, total);
+    word.resize(keep + length);
+    for (size_t i = 0; i < length; ++i) {
+        word[keep + i] = RandomLetter(rng);
+    }
+}
+
+// Consecutive Collide draws rejected before the length cap is raised: many
+// times the expected number of draws per colliding word.
+const size_t kMaxRejections = 64 * kCollisionModulus;
+
+struct ShorterFirst {
+    bool operator()(const std::string& a, const std::string& b) const {
+        return a.size() < b.size();
+    }
+};
+
+// Distinct words, shortest first so that they get the highest Zipf ranks.
+ArraySequence<std::string> BuildVocabulary(SplitMix64& rng, const CorpusOptions& options, size_t size) {
+    HashTable<std::string, int> seen;
+    ArraySequence<std::string> words;
+    std::string word;
+    size_t keep = 0;
+    size_t target_hash = 0;
+    size_t max_length = options.max_length;
+    size_t rejections = 0;
+    if (options.kind == CorpusKind::Prefix) {
+        for (keep = 0; keep < kSharedPrefixLength; ++keep) {
+            word.push_back(RandomLetter(rng));
+        }
+    }
+    std::hash<std::string> hasher;
+    while (words.GetLength() < size) {
+        RandomWord(rng, max_length, keep, word);
+        // The hash filter rejects almost every draw, so it goes before the
+        // (much slower) duplicate check.
+        if (options.kind == CorpusKind::Collide) {
+            size_t bucket = hasher(word) % kCollisionModulus;
+            if (words.GetLength() == 0) {
+                target_hash = bucket;
+            } else if (bucket != target_hash || seen.ContainsKey(word)) {
+                // Short lengths hold few colliding words, or none: allow
+                // longer ones once the draws keep failing.
+                if (++rejections == kMaxRejections) {
+                    ++max_length;
+                    rejections = 0;
+                }
+                continue;
+            }
+            rejections = 0;
+        }
+        // Short lengths run out of distinct words quickly: lengthen instead
+        // of drawing again forever.
+        while (seen.ContainsKey(word)) {
+            word.push_back(RandomLetter(rng));
+        }
+        seen.Add(word, 0);
+        words.Append(word);
+    }
+    SortedSequence<std::string, ShorterFirst> ordered(std::move(words));
+    ArraySequence<std::string> res(ordered.GetLength());
+    for (size_t i = 0; i < ordered.GetLength(); ++i) {
+        res.Set(ordered.Get(i), i);
+    }
+    return res;
+}
+
+}  // namespace
+
+std::string GenerateCyclicText(size_t count, size_t max_len) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz";
+    std::ostringstream ss;
+    for (size_t i = 0; i < count; ++i) {
+        size_t len = 1 + (i % max_len);
+        for (size_t j = 0; j < len; ++j) {
+            ss << alphabet[(i + j) % (sizeof(alphabet) - 1)];
+        }
+        ss << ' ';
+    }
+    return ss.str();
+}
+
+std::string GenerateCorpus(size_t count, const CorpusOptions& options) {
+    if (options.kind == CorpusKind::Cyclic) {
+        return GenerateCyclicText(count, options.max_length == 0 ? 1 : options.max_length);
+    }
+    if (count == 0 || options.vocabulary == 0) {
+        return std::string();
+    }
+    // A text cannot use more distinct words than it has.
+    SplitMix64 rng(options.seed);
+    ArraySequence<std::string> vocabulary =
+        BuildVocabulary(rng, options, options.vocabulary < count ? options.vocabulary : count);
+
+    // P(rank k) ~ 1 / k^s; words are drawn by binary search on the CDF.
+    size_t size = vocabulary.GetLength();
+    ArraySequence<double> cdf(size);
+    double total = 0;
+    for (size_t k = 0; k < size; ++k) {
+        total += 1.0 / std::pow(static_cast<double>(k + 1), options.zipf_s);
+        cdf.Set(total, k);
+    }
+
+    std::string text;
+    for (size_t i = 0; i < count; ++i) {
+        double r = rng.NextDouble() * total;
+        size_t l = 0;
+        size_t h = size - 1;
+        while (l < h) {
+            size_t mid = (l + h) / 2;
+            if (cdf.Get(mid) <= r) {
+                l = mid + 1;
+            } else {
+                h = mid;
+            }
+        }
+        text += vocabulary.Get(l);
+        text.push_back(' ');
+    }
+    return text;
+}
+
+const char* CorpusKindName(CorpusKind kind) {
+    switch (kind) {
+        case CorpusKind::Cyclic:
+            return "cyclic";
+        case CorpusKind::Zipf:
+            return "zipf";
+        case CorpusKind::Collide:
+            return "collide";
+        case CorpusKind::Prefix:
+            return "prefix";
+    }
+    return "";
+}
+
+bool ParseCorpusKind(const std::string& name, CorpusKind& kind) {
+    for (CorpusKind k : {CorpusKind::Cyclic, CorpusKind::Zipf, CorpusKind::Collide, CorpusKind::Prefix}) {
+        if (name == CorpusKindName(k)) {
+            kind = k;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class CorpusKind {
+    Cyclic,   // the old deterministic pattern, kept for comparison
+    Zipf,     // Zipf-distributed draws from a random vocabulary
+    Collide,  // Zipf draws from a vocabulary whose hashes agree modulo kCollisionModulus
+    Prefix,   // Zipf draws from a vocabulary sharing a long common prefix
+};
+
+struct CorpusOptions {
+    CorpusKind kind = CorpusKind::Zipf;
+    uint64_t seed = 1;
+    size_t vocabulary = 10000;
+    double zipf_s = 1.0;
+    size_t max_length = 16;
+};
+
+// Words of the Collide vocabulary have equal std::hash values modulo this,
+// so a table indexing buckets by the raw hash modulo 11 * 2^k would chain
+// them together. HashTable mixes hashes with a per-table seed first, which
+// spreads them; they only share a full hash under a hasher that keeps no
+// more than this modulus (TruncatedHash, --backend=weakhash in the CLI).
+inline constexpr size_t kCollisionModulus = 11 << 8;
+
+// Length of the prefix shared by every word of the Prefix vocabulary.
+inline constexpr size_t kSharedPrefixLength = 24;
+
+// Small fast generator (splitmix64) so that a seed gives the same corpus on
+// every platform, unlike the std:: distributions.
+class SplitMix64 {
+public:
+    explicit SplitMix64(uint64_t seed) : state_(seed) {
+    }
+
+    uint64_t Next() {
+        uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1).
+    double NextDouble() {
+        return static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+private:
+    uint64_t state_;
+};
+
+std::string GenerateCyclicText(size_t count, size_t max_len);
+
+// Space-separated text of `count` words. Word lengths and letters follow
+// English frequencies (lengths are capped at max_length unless the
+// vocabulary does not fit), and the most frequent words are the shortest.
+std::string GenerateCorpus(size_t count, const CorpusOptions& options);
+
+const char* CorpusKindName(CorpusKind kind);
+bool ParseCorpusKind(const std::string& name, CorpusKind& kind);
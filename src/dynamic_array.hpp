@@ -1,30 +1,45 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+
+#include "bounds_check.hpp"
+#include "memory.hpp"
 
 template <typename T>
 class DynamicArray {
 public:
-    DynamicArray(const T* items, size_t count) : size_(count) {
-        data_ = new T[size_]();
-        for (size_t i = 0; i < size_; ++i) {
-            data_[i] = items[i];
+    DynamicArray(const T* items, size_t count, std::pmr::memory_resource* resource = DefaultResource())
+        : size_(count), resource_(resource) {
+        if (size_ != 0) {
+            data_ = Allocate(size_);
+            capacity_ = size_;
+            for (size_t i = 0; i < size_; ++i) {
+                data_[i] = items[i];
+            }
         }
     }
 
     DynamicArray() {
     }
 
-    DynamicArray(size_t size) : size_(size) {
+    DynamicArray(size_t size, std::pmr::memory_resource* resource = DefaultResource())
+        : size_(size), resource_(resource) {
         if (size != 0) {
-            data_ = new T[size]();
+            data_ = Allocate(size);
+            capacity_ = size;
         }
     }
 
     DynamicArray(const DynamicArray<T>& v) : size_(v.size_) {
         if (size_ != 0) {
-            data_ = new T[size_]();
+            data_ = Allocate(size_);
+            capacity_ = size_;
             for (size_t i = 0; i < size_; ++i) {
                 data_[i] = v.data_[i];
             }
@@ -32,12 +47,14 @@ public:
     }
 
     DynamicArray<T>& operator=(const DynamicArray<T>& v) {
-        if (data_ != nullptr) {
-            delete[] data_;
+        if (this == &v) {
+            return *this;
         }
+        Release();
         size_ = v.size_;
         if (size_ != 0) {
-            data_ = new T[size_]();
+            data_ = Allocate(size_);
+            capacity_ = size_;
             for (size_t i = 0; i < size_; ++i) {
                 data_[i] = v.data_[i];
             }
@@ -46,31 +63,44 @@ public:
     }
 
     DynamicArray<T>& operator=(DynamicArray<T>&& v) {
-        if (data_ != nullptr) {
-            delete[] data_;
+        if (this == &v) {
+            return *this;
         }
+        Release();
         size_ = v.size_;
+        capacity_ = v.capacity_;
         data_ = v.data_;
+        resource_ = v.resource_;
         v.size_ = 0;
+        v.capacity_ = 0;
         v.data_ = nullptr;
         return *this;
     }
 
-    DynamicArray(DynamicArray<T>&& v) : size_(v.size_), data_(v.data_) {
+    DynamicArray(DynamicArray<T>&& v)
+        : size_(v.size_), capacity_(v.capacity_), data_(v.data_), resource_(v.resource_) {
         v.size_ = 0;
+        v.capacity_ = 0;
         v.data_ = nullptr;
     }
 
     ~DynamicArray() {
-        if (data_ != nullptr) {
-            delete[] data_;
-        }
+        Release();
     }
 
     const T& Get(size_t index) const {
-        if (index >= size_) {
-            throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
-        }
+        CheckIndex(index, size_);
+        return data_[index];
+    }
+
+    // Unchecked access for indices that are valid by construction.
+    const T& operator[](size_t index) const {
+        CheckIndexIfEnabled(index, size_);
+        return data_[index];
+    }
+
+    T& operator[](size_t index) {
+        CheckIndexIfEnabled(index, size_);
         return data_[index];
     }
 
@@ -79,9 +109,7 @@ public:
     }
 
     void Set(const T& item, size_t index) {
-        if (index >= size_) {
-            throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
-        }
+        CheckIndex(index, size_);
         data_[index] = item;
     }
 
@@ -90,20 +118,67 @@ public:
             size_ = newSize;
             return;
         }
-        T* newData = new T[newSize]();
+        T* newData = Allocate(newSize);
         for (size_t i = 0; i < size_; ++i) {
-            newData[i] = data_[i];
+            newData[i] = std::move(data_[i]);
         }
-        delete[] data_;
+        Release();
         data_ = newData;
         size_ = newSize;
+        capacity_ = newSize;
     }
 
     const T* GetBegin() const {
         return data_;
     }
 
+    T* GetBegin() {
+        return data_;
+    }
+
+    std::pmr::memory_resource* GetResource() const {
+        return resource_;
+    }
+
 private:
+    T* Allocate(size_t count) {
+        T* data = static_cast<T*>(resource_->allocate(count * sizeof(T), alignof(T)));
+        try {
+            std::uninitialized_value_construct_n(data, count);
+        } catch (...) {
+            resource_->deallocate(data, count * sizeof(T), alignof(T));
+            throw;
+        }
+        return data;
+    }
+
+    void Release() {
+        if (data_ != nullptr) {
+            std::destroy_n(data_, capacity_);
+            resource_->deallocate(data_, capacity_ * sizeof(T), alignof(T));
+            data_ = nullptr;
+        }
+    }
+
     size_t size_ = 0;
+    size_t capacity_ = 0;
     T* data_ = nullptr;
+    std::pmr::memory_resource* resource_ = DefaultResource();
 };
+
+// Moves `count` elements from `from` to `to`; the ranges may overlap. The
+// elements left behind are moved-from. Trivially copyable types are moved
+// with a single memmove.
+template <typename T>
+void MoveElements(T* from, size_t count, T* to) {
+    if (count == 0 || from == to) {
+        return;
+    }
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        std::memmove(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+    } else if (to < from) {
+        std::move(from, from + count, to);
+    } else {
+        std::move_backward(from, from + count, to + count);
+    }
+}
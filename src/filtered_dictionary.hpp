@@ -0,0 +1,154 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#include "bloom_filter.hpp"
+#include "hash_table.hpp"
+#include "idictionary.hpp"
+#include "stats.hpp"
+
+// Puts a Bloom filter in front of another dictionary so that most lookups of
+// absent keys are answered without touching it. The filter is built from
+// the dictionary's keys and follows Add; Remove cannot clear filter bits, so
+// removed keys only cost a false positive until enough of them pile up and
+// the filter is rebuilt.
+template <typename Key, typename Value, typename Hasher = std::hash<Key>>
+class FilteredDictionary : public IDictionary<Key, Value> {
+public:
+    explicit FilteredDictionary(IDictionaryPtr<Key, Value> inner, Hasher hasher = Hasher())
+        : inner_(std::move(inner)), hasher_(std::move(hasher)), filter_(0) {
+        Rebuild(inner_->GetCount());
+    }
+
+    size_t GetCount() const override {
+        return inner_->GetCount();
+    }
+
+    size_t GetCapacity() const override {
+        return inner_->GetCapacity();
+    }
+
+    const Value& Get(const Key& key) const override {
+        if (!MayContain(key)) {
+            throw std::out_of_range("No such key");
+        }
+        try {
+            return inner_->Get(key);
+        } catch (const std::out_of_range&) {
+            LAB2_STAT(++stats_.false_positives);
+            throw;
+        }
+    }
+
+    bool ContainsKey(const Key& key) const override {
+        if (!MayContain(key)) {
+            return false;
+        }
+        bool found = inner_->ContainsKey(key);
+        LAB2_STAT(stats_.false_positives += found ? 0 : 1);
+        return found;
+    }
+
+    void Add(const Key& key, const Value& value) override {
+        inner_->Add(key, value);
+        if (inner_->GetCount() > capacity_) {
+            Rebuild(2 * inner_->GetCount());
+        } else {
+            filter_.Add(Hash(key));
+        }
+    }
+
+    void Remove(const Key& key) override {
+        inner_->Remove(key);
+        if (++stale_ > inner_->GetCount()) {
+            Rebuild(inner_->GetCount());
+        }
+    }
+
+    void Reserve(size_t count) override {
+        inner_->Reserve(count);
+        if (count > capacity_) {
+            Rebuild(count);
+        }
+    }
+
+    SequencePtr<Key> GetKeys() const override {
+        return inner_->GetKeys();
+    }
+
+    SequencePtr<Value> GetValues() const override {
+        return inner_->GetValues();
+    }
+
+    IIteratorPtr<KeyValue<Key, Value>> GetIterator() const override {
+        return inner_->GetIterator();
+    }
+
+    IIteratorPtr<KeyValue<Key, Value>> GetSortedIterator() const override {
+        return inner_->GetSortedIterator();
+    }
+
+    const IDictionaryPtr<Key, Value>& GetInner() const {
+        return inner_;
+    }
+
+    size_t GetFilterByteSize() const {
+        return filter_.GetByteSize();
+    }
+
+    FilterStats GetStats() const {
+#ifdef LAB2_STATS
+        return stats_;
+#else
+        return FilterStats{};
+#endif
+    }
+
+    void ResetStats() {
+#ifdef LAB2_STATS
+        stats_ = FilterStats{};
+#endif
+    }
+
+private:
+    uint64_t Hash(const Key& key) const {
+        return MixHash(static_cast<uint64_t>(hasher_(key)));
+    }
+
+    bool MayContain(const Key& key) const {
+        LAB2_STAT(++stats_.queries);
+        if (filter_.MayContain(Hash(key))) {
+            return true;
+        }
+        LAB2_STAT(++stats_.rejected);
+        return false;
+    }
+
+    // Sizes a fresh filter for `capacity` keys and fills it from the inner
+    // dictionary.
+    void Rebuild(size_t capacity) {
+        capacity_ = capacity < inner_->GetCount() ? inner_->GetCount() : capacity;
+        filter_ = BlockedBloomFilter(capacity_);
+        for (auto it = inner_->GetIterator(); it->HasNext(); it->Next()) {
+            filter_.Add(Hash(it->GetCurrentItem().key));
+        }
+        stale_ = 0;
+    }
+
+    IDictionaryPtr<Key, Value> inner_;
+    Hasher hasher_;
+    BlockedBloomFilter filter_;
+    size_t capacity_ = 0;
+    size_t stale_ = 0;
+#ifdef LAB2_STATS
+    mutable FilterStats stats_;
+#endif
+};
+
+// Wraps a finished index in a FilteredDictionary.
+template <typename Key, typename Value>
+IDictionaryPtr<Key, Value> WithFilter(IDictionaryPtr<Key, Value> index) {
+    return std::make_shared<FilteredDictionary<Key, Value>>(std::move(index));
+}
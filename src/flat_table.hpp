@@ -1,92 +1,275 @@
 #pragma once
 
+#include <cstdint>
+#include <memory_resource>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
 
+#include "array_sequence.hpp"
+#include "hash_table.hpp"
 #include "idictionary.hpp"
-#include "isorted_sequence.hpp"
-#include "list_sequence.hpp"
-#include "sorted_sequence.hpp"
+#include "isorted_dictionary.hpp"
+#include "memory.hpp"
+#include "parallel_sort.hpp"
+#include "sequence_view.hpp"
+#include "stats.hpp"
+#include "string_sort.hpp"
 
+// Walks the parallel key and value arrays of a FlatTable as key-value pairs.
+// Next() only moves the position; the pair is copied out of the arrays the
+// first time GetCurrentItem asks for it.
 template <typename Key, typename Value>
-class FlatTable : public IDictionary<Key, Value> {
-    struct KeyCompare {
-        bool operator()(const KeyValue<Key, Value>& a, const KeyValue<Key, Value>& b) const {
-            return a.key < b.key;
+class FlatTableIterator : public IIterator<KeyValue<Key, Value>> {
+    using Pair = KeyValue<Key, Value>;
+
+public:
+    FlatTableIterator(const Key* keys, const Value* values, size_t size)
+        : keys_(keys), values_(values), size_(size) {
+    }
+
+    bool HasNext() const override {
+        return index_ < size_;
+    }
+
+    bool Next() override {
+        if (!HasNext()) {
+            return false;
+        }
+        ++index_;
+        return true;
+    }
+
+    const Pair& GetCurrentItem() const override {
+        if (!HasNext()) {
+            throw std::out_of_range("No next element");
+        }
+        if (!loaded_ || loaded_index_ != index_) {
+            current_.key = keys_[index_];
+            current_.value = values_[index_];
+            loaded_index_ = index_;
+            loaded_ = true;
+        }
+        return current_;
+    }
+
+    bool TryGetCurrentItem(Pair& element) const override {
+        if (!HasNext()) {
+            return false;
         }
-    };
+        element.key = keys_[index_];
+        element.value = values_[index_];
+        return true;
+    }
 
+private:
+    const Key* keys_;
+    const Value* values_;
+    const size_t size_;
+    size_t index_ = 0;
+    mutable Pair current_;
+    mutable size_t loaded_index_ = 0;
+    mutable bool loaded_ = false;
+};
+
+// Sorted array dictionary stored as a struct of arrays: keys, values and, for
+// string keys, the first eight bytes of every key packed big-endian into an
+// integer. A binary search compares the packed prefixes and only reads a key
+// when its prefix ties with the one searched for, so the probes stay inside
+// one dense array; the value is read once the position is known.
+template <typename Key, typename Value>
+class FlatTable : public ISortedDictionary<Key, Value> {
     using Pair = KeyValue<Key, Value>;
-    using Seq = SortedSequence<Pair, KeyCompare>;
+
+    static constexpr bool kPrefixed = std::is_same_v<Key, std::string>;
 
 public:
-    FlatTable() : data_(std::make_shared<Seq>()) {
+    // BuildBook collects the index here and bulk-builds the table once:
+    // sorting the whole vocabulary beats shifting the array on every insert.
+    using Staging = HashTable<Key, Value>;
+
+    FlatTable() : FlatTable(DefaultResource()) {
+    }
+
+    explicit FlatTable(std::pmr::memory_resource* resource)
+        : keys_(resource), values_(resource), prefixes_(resource) {
+    }
+
+    explicit FlatTable(const IDictionary<Key, Value>& source, std::pmr::memory_resource* resource = DefaultResource())
+        : keys_(source.GetCount(), resource),
+          values_(source.GetCount(), resource),
+          prefixes_(kPrefixed ? source.GetCount() : 0, resource) {
+        ArraySequence<Pair> pairs(source.GetCount(), resource);
+        size_t i = 0;
+        for (auto it = source.GetIterator(); it->HasNext(); it->Next()) {
+            pairs.Set(it->GetCurrentItem(), i++);
+        }
+        if constexpr (StringSortKey<Pair, KeyLess<Key, Value>>::kEnabled) {
+            StringRadixSort<Pair, KeyLess<Key, Value>>(pairs.GetBegin(), pairs.GetLength());
+        } else {
+            ParallelMergeSort(pairs.GetBegin(), pairs.GetLength(), KeyLess<Key, Value>());
+        }
+        for (i = 0; i < pairs.GetLength(); ++i) {
+            const Pair& pair = pairs[i];
+            keys_.Set(pair.key, i);
+            values_.Set(pair.value, i);
+            if constexpr (kPrefixed) {
+                prefixes_.Set(KeyPrefix(pair.key), i);
+            }
+        }
     }
 
     size_t GetCount() const override {
-        return data_->GetLength();
+        return keys_.GetLength();
     }
 
     size_t GetCapacity() const override {
-        return data_->GetLength();
+        return keys_.GetLength();
     }
 
     const Value& Get(const Key& key) const override {
         size_t idx = LowerIndex(key);
-        if (idx == data_->GetLength() || data_->Get(idx).key != key) {
+        if (!IsAt(idx, key)) {
             throw std::out_of_range("No such key");
         }
-        return data_->Get(idx).value;
+        return values_[idx];
     }
 
     bool ContainsKey(const Key& key) const override {
-        size_t idx = LowerIndex(key);
-        return idx < data_->GetLength() && data_->Get(idx).key == key;
+        return IsAt(LowerIndex(key), key);
     }
 
     void Add(const Key& key, const Value& value) override {
         size_t idx = LowerIndex(key);
-        if (idx < data_->GetLength() && data_->Get(idx).key == key) {
-            Pair updated{key, value};
-            data_->EraseAt(idx);
-            data_->Add(updated);
+        if (IsAt(idx, key)) {
+            values_.Set(value, idx);
             return;
         }
-        data_->Add(Pair{key, value});
+        keys_.InsertAt(key, idx);
+        values_.InsertAt(value, idx);
+        if constexpr (kPrefixed) {
+            prefixes_.InsertAt(KeyPrefix(key), idx);
+        }
+    }
+
+    void Reserve(size_t count) override {
+        keys_.Reserve(count);
+        values_.Reserve(count);
+        if constexpr (kPrefixed) {
+            prefixes_.Reserve(count);
+        }
     }
 
     void Remove(const Key& key) override {
         size_t idx = LowerIndex(key);
-        if (idx == data_->GetLength() || data_->Get(idx).key != key) {
+        if (!IsAt(idx, key)) {
             throw std::out_of_range("No such key");
         }
-        data_->EraseAt(idx);
+        keys_.EraseAt(idx);
+        values_.EraseAt(idx);
+        if constexpr (kPrefixed) {
+            prefixes_.EraseAt(idx);
+        }
     }
 
     SequencePtr<Key> GetKeys() const override {
-        auto res = std::make_shared<ListSequence<Key>>();
-        for (auto it = data_->GetIterator(); it->HasNext(); it->Next()) {
-            res->Append(it->GetCurrentItem().key);
-        }
-        return res;
+        return ShareArray(keys_);
     }
 
     SequencePtr<Value> GetValues() const override {
-        auto res = std::make_shared<ListSequence<Value>>();
-        for (auto it = data_->GetIterator(); it->HasNext(); it->Next()) {
-            res->Append(it->GetCurrentItem().value);
-        }
-        return res;
+        return ShareArray(values_);
     }
 
     IIteratorPtr<Pair> GetIterator() const override {
-        return data_->GetIterator();
+        return MakeIterator(0, keys_.GetLength());
+    }
+
+    IIteratorPtr<Pair> Range(const Key& lo, const Key& hi) const override {
+        size_t begin = LowerIndex(lo);
+        size_t end = LowerIndex(hi);
+        return MakeIterator(begin, end < begin ? begin : end);
+    }
+
+    IIteratorPtr<Pair> RangeFrom(const Key& lo) const override {
+        return MakeIterator(LowerIndex(lo), keys_.GetLength());
+    }
+
+    // Lookups and their binary-search probes; every operation is one
+    // LowerIndex over the key arrays.
+    LookupStats GetStats() const {
+#ifdef LAB2_STATS
+        return stats_;
+#else
+        return LookupStats{};
+#endif
+    }
+
+    void ResetStats() {
+#ifdef LAB2_STATS
+        stats_ = LookupStats{};
+#endif
     }
 
 private:
+    // The first eight bytes of `key`, zero-padded, as a big-endian integer:
+    // prefixes compare in the same order as the keys, ties aside.
+    static uint64_t KeyPrefix(const std::string& key) {
+        uint64_t prefix = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            prefix = (prefix << 8) | (i < key.size() ? static_cast<unsigned char>(key[i]) : 0);
+        }
+        return prefix;
+    }
+
+    bool IsAt(size_t idx, const Key& key) const {
+        return idx < keys_.GetLength() && keys_.GetBegin()[idx] == key;
+    }
+
+    // Position of the first key not less than `key`.
     size_t LowerIndex(const Key& key) const {
-        return data_->LowerBound(Pair{key, Value{}});
+        LAB2_STAT(++stats_.lookups);
+        const Key* keys = keys_.GetBegin();
+        size_t l = 0;
+        size_t r = keys_.GetLength();
+        if constexpr (kPrefixed) {
+            const uint64_t* prefixes = prefixes_.GetBegin();
+            const uint64_t prefix = KeyPrefix(key);
+            while (l < r) {
+                size_t mid = l + (r - l) / 2;
+                LAB2_STAT(++stats_.probes);
+                LAB2_STAT(++stats_.comparisons);
+                if (prefixes[mid] < prefix || (prefixes[mid] == prefix && keys[mid] < key)) {
+                    l = mid + 1;
+                } else {
+                    r = mid;
+                }
+            }
+        } else {
+            while (l < r) {
+                size_t mid = l + (r - l) / 2;
+                LAB2_STAT(++stats_.probes);
+                LAB2_STAT(++stats_.comparisons);
+                if (keys[mid] < key) {
+                    l = mid + 1;
+                } else {
+                    r = mid;
+                }
+            }
+        }
+        return l;
+    }
+
+    IIteratorPtr<Pair> MakeIterator(size_t begin, size_t end) const {
+        return std::make_shared<FlatTableIterator<Key, Value>>(keys_.GetBegin() + begin, values_.GetBegin() + begin,
+                                                                end - begin);
     }
 
 private:
-    std::shared_ptr<Seq> data_;
+    ArraySequence<Key> keys_;
+    ArraySequence<Value> values_;
+    // Packed key prefixes, parallel to keys_; empty unless kPrefixed.
+    ArraySequence<uint64_t> prefixes_;
+#ifdef LAB2_STATS
+    mutable LookupStats stats_;
+#endif
 };
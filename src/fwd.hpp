@@ -19,3 +19,9 @@ class IDictionary;
 
 template <typename Key, typename Value>
 using IDictionaryPtr = std::shared_ptr<IDictionary<Key, Value>>;
+
+template <typename Key, typename Value>
+class ISortedDictionary;
+
+template <typename Key, typename Value>
+using ISortedDictionaryPtr = std::shared_ptr<ISortedDictionary<Key, Value>>;
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+
+#include "array_sequence.hpp"
+#include "bounds_check.hpp"
+#include "dynamic_array.hpp"
+#include "sequence.hpp"
+
+// Iterates over a gap buffer, stepping over the gap.
+template <typename T>
+class GapBufferIterator : public IIterator<T> {
+public:
+    GapBufferIterator(const T* data, size_t gap_begin, size_t gap_size, size_t begin, size_t end)
+        : data_(data), gap_begin_(gap_begin), gap_size_(gap_size), index_(begin), end_(end) {
+    }
+
+    bool HasNext() const override {
+        return index_ < end_;
+    }
+
+    bool Next() override {
+        if (!HasNext()) {
+            return false;
+        }
+        ++index_;
+        return true;
+    }
+
+    const T& GetCurrentItem() const override {
+        if (!HasNext()) {
+            throw std::out_of_range("No next element");
+        }
+        return data_[index_ < gap_begin_ ? index_ : index_ + gap_size_];
+    }
+
+    bool TryGetCurrentItem(T& element) const override {
+        if (!HasNext()) {
+            return false;
+        }
+        element = GetCurrentItem();
+        return true;
+    }
+
+private:
+    const T* data_;
+    const size_t gap_begin_;
+    const size_t gap_size_;
+    size_t index_;
+    const size_t end_;
+};
+
+// Array with a movable gap of free slots. An insert or erase moves the gap to
+// its position first, shifting only the elements between the old and the new
+// position, so a run of edits close to each other costs about as much as
+// edits at the end of an ArraySequence. Random positions cost the same as
+// there. GetBegin() closes the gap to expose the elements contiguously.
+template <typename T>
+class GapBufferSequence : public Sequence<T> {
+public:
+    GapBufferSequence(const T* items, size_t count, std::pmr::memory_resource* resource = DefaultResource())
+        : data_(count == 0 ? DynamicArray<T>(1, resource) : DynamicArray<T>(items, count, resource)),
+          gap_begin_(count),
+          gap_end_(data_.GetSize()) {
+    }
+
+    GapBufferSequence(const Sequence<T>& a, std::pmr::memory_resource* resource = DefaultResource())
+        : data_(a.GetLength() == 0 ? 1 : a.GetLength(), resource), gap_begin_(0), gap_end_(data_.GetSize()) {
+        for (IIteratorPtr<T> it = a.GetIterator(); it->HasNext(); it->Next()) {
+            Append(it->GetCurrentItem());
+        }
+    }
+
+    GapBufferSequence(SequencePtr<T> a) : GapBufferSequence(*a) {
+    }
+
+    explicit GapBufferSequence(std::pmr::memory_resource* resource)
+        : data_(1, resource), gap_begin_(0), gap_end_(data_.GetSize()) {
+    }
+
+    GapBufferSequence() : GapBufferSequence(DefaultResource()) {
+    }
+
+    const T& GetFirst() const override {
+        if (GetLength() == 0) {
+            throw std::out_of_range("Sequence is empty");
+        }
+        return At(0);
+    }
+
+    const T& GetLast() const override {
+        if (GetLength() == 0) {
+            throw std::out_of_range("Sequence is empty");
+        }
+        return At(GetLength() - 1);
+    }
+
+    const T& Get(size_t index) const override {
+        CheckIndex(index, GetLength());
+        return At(index);
+    }
+
+    // Unchecked access for indices that are valid by construction.
+    const T& operator[](size_t index) const {
+        CheckIndexIfEnabled(index, GetLength());
+        return At(index);
+    }
+
+    void Set(const T& item, size_t index) override {
+        CheckIndex(index, GetLength());
+        data_.GetBegin()[Physical(index)] = item;
+    }
+
+    SequencePtr<T> GetSubsequence(size_t startIndex, size_t endIndex) const override {
+        if (startIndex >= GetLength() || endIndex >= GetLength()) {
+            throw std::out_of_range("Index is out of range: " + std::to_string(startIndex) + " " +
+                                    std::to_string(endIndex) + " " + std::to_string(GetLength()));
+        }
+        if (startIndex > endIndex) {
+            throw std::out_of_range("startIndex is greater than endIndex");
+        }
+        return std::make_shared<GapBufferSequence<T>>(Slice(startIndex, endIndex + 1));
+    }
+
+    SequencePtr<T> GetFirst(size_t count) const override {
+        if (count == 0) {
+            return std::make_shared<GapBufferSequence<T>>();
+        }
+        if (count > GetLength()) {
+            throw std::out_of_range("Requested elements count is greater than size");
+        }
+        return GetSubsequence(0, count - 1);
+    }
+
+    SequencePtr<T> GetLast(size_t count) const override {
+        if (count == 0) {
+            return std::make_shared<GapBufferSequence<T>>();
+        }
+        if (count > GetLength()) {
+            throw std::out_of_range("Requested elements count is greater than size");
+        }
+        return GetSubsequence(GetLength() - count, GetLength() - 1);
+    }
+
+    // A copy of elements [begin, end); the buffer is not shared.
+    GapBufferSequence<T> Slice(size_t begin, size_t end) const {
+        if (begin > end || end > GetLength()) {
+            throw std::out_of_range("Index is out of range: " + std::to_string(begin) + " " + std::to_string(end) +
+                                    " " + std::to_string(GetLength()));
+        }
+        GapBufferSequence<T> slice(data_.GetResource());
+        slice.Reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            slice.Append(At(i));
+        }
+        return slice;
+    }
+
+    size_t GetLength() const override {
+        return data_.GetSize() - GapSize();
+    }
+
+    size_t GetCapacity() const override {
+        return data_.GetSize();
+    }
+
+    void Reserve(size_t capacity) override {
+        if (capacity > data_.GetSize()) {
+            Grow(capacity);
+        }
+    }
+
+    void Append(const T& item) override {
+        Insert(item, GetLength());
+    }
+
+    void Prepend(const T& item) override {
+        Insert(item, 0);
+    }
+
+    void InsertAt(const T& item, size_t index) override {
+        Insert(item, index);
+    }
+
+    void EraseAt(size_t index) override {
+        CheckIndex(index, GetLength());
+        MoveGap(index);
+        ++gap_end_;
+    }
+
+    void Clear() override {
+        gap_begin_ = 0;
+        gap_end_ = data_.GetSize();
+    }
+
+    // Moves the gap behind the last element; the pointer is valid until the
+    // next insert or erase.
+    T* GetBegin() {
+        MoveGap(GetLength());
+        return data_.GetBegin();
+    }
+
+    IIteratorPtr<T> GetIterator() const override {
+        return GetRangeIterator(0, GetLength());
+    }
+
+    // Iterates over [begin, end) without copying the elements.
+    IIteratorPtr<T> GetRangeIterator(size_t begin, size_t end) const {
+        if (begin > end || end > GetLength()) {
+            throw std::out_of_range("Index is out of range: " + std::to_string(begin) + " " + std::to_string(end) +
+                                    " " + std::to_string(GetLength()));
+        }
+        return std::make_shared<GapBufferIterator<T>>(data_.GetBegin(), gap_begin_, GapSize(), begin, end);
+    }
+
+private:
+    size_t GapSize() const {
+        return gap_end_ - gap_begin_;
+    }
+
+    size_t Physical(size_t index) const {
+        return index < gap_begin_ ? index : index + GapSize();
+    }
+
+    const T& At(size_t index) const {
+        return data_.GetBegin()[Physical(index)];
+    }
+
+    // Shifts the elements between the gap and `index` across the gap.
+    void MoveGap(size_t index) {
+        T* data = data_.GetBegin();
+        if (index < gap_begin_) {
+            size_t count = gap_begin_ - index;
+            MoveElements(data + index, count, data + gap_end_ - count);
+            gap_begin_ -= count;
+            gap_end_ -= count;
+        } else if (index > gap_begin_) {
+            size_t count = index - gap_begin_;
+            MoveElements(data + gap_end_, count, data + gap_begin_);
+            gap_begin_ += count;
+            gap_end_ += count;
+        }
+    }
+
+    // Reallocates to `capacity`, keeping the gap where it is.
+    void Grow(size_t capacity) {
+        DynamicArray<T> grown(capacity, data_.GetResource());
+        size_t tail = data_.GetSize() - gap_end_;
+        MoveElements(data_.GetBegin(), gap_begin_, grown.GetBegin());
+        MoveElements(data_.GetBegin() + gap_end_, tail, grown.GetBegin() + capacity - tail);
+        data_ = std::move(grown);
+        gap_end_ = capacity - tail;
+    }
+
+    void Insert(const T& item, size_t index) {
+        if (index > GetLength()) {
+            ThrowIndexOutOfRange(index, GetLength());
+        }
+        if (GapSize() == 0) {
+            Grow(data_.GetSize() * 2);
+        }
+        MoveGap(index);
+        data_.GetBegin()[gap_begin_++] = item;
+    }
+
+    DynamicArray<T> data_;
+    size_t gap_begin_;
+    size_t gap_end_;
+};
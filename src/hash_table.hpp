@@ -1,12 +1,82 @@
 #pragma once
 
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <memory_resource>
 #include <stdexcept>
 #include <utility>
 
 #include "array_sequence.hpp"
+#include "dynamic_array.hpp"
 #include "idictionary.hpp"
-#include "list_sequence.hpp"
+#include "memory.hpp"
+#include "parallel_sort.hpp"
+#include "sequence_view.hpp"
+#include "small_sequence.hpp"
+#include "stats.hpp"
+#include "string_sort.hpp"
+
+// SplitMix64 finalizer. Spreads the hasher's output (seeded per table) over
+// all bits, so that keys whose hashes differ only in high bits or by a
+// multiple of the capacity still land in different buckets.
+inline uint64_t MixHash(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+// One bit per bucket, set while the bucket holds a chain. Iteration jumps
+// over runs of empty buckets 64 at a time, so a sparse table is walked in
+// time proportional to its entries rather than its capacity.
+class OccupancyBitmap {
+public:
+    explicit OccupancyBitmap(size_t size, std::pmr::memory_resource* resource = DefaultResource())
+        : words_((size + 63) / 64, resource), size_(size) {
+        for (size_t i = 0; i < words_.GetSize(); ++i) {
+            words_.GetBegin()[i] = 0;
+        }
+    }
+
+    void Set(size_t index) {
+        words_.GetBegin()[index / 64] |= uint64_t{1} << (index % 64);
+    }
+
+    void Clear(size_t index) {
+        words_.GetBegin()[index / 64] &= ~(uint64_t{1} << (index % 64));
+    }
+
+    // First set bit at or after `from`, or the size if there is none.
+    size_t Next(size_t from) const {
+        if (from >= size_) {
+            return size_;
+        }
+        const uint64_t* words = words_.GetBegin();
+        size_t word = from / 64;
+        uint64_t bits = words[word] & (~uint64_t{0} << (from % 64));
+        while (bits == 0) {
+            if (++word == words_.GetSize()) {
+                return size_;
+            }
+            bits = words[word];
+        }
+        return word * 64 + std::countr_zero(bits);
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+private:
+    DynamicArray<uint64_t> words_;
+    size_t size_;
+};
 
 template <typename Key, typename Value>
 class HashTableIterator : public IIterator<KeyValue<Key, Value>> {
@@ -14,69 +84,94 @@ class HashTableIterator : public IIterator<KeyValue<Key, Value>> {
     using ChainPtr = SequencePtr<KeyValuePtr>;
 
 public:
-    explicit HashTableIterator(SequencePtr<ChainPtr> table) : table_(std::move(table)) {
-        if (table_ != nullptr) {
-            table_it_ = table_->GetIterator();
-            AdvanceToNextNonEmptyChain(false);
-        }
+    HashTableIterator(SequencePtr<ChainPtr> table, std::shared_ptr<const OccupancyBitmap> occupied)
+        : table_(std::move(table)), occupied_(std::move(occupied)), bucket_(occupied_->Next(0)) {
     }
 
     bool HasNext() const override {
-        return chain_it_ != nullptr && chain_it_->HasNext();
+        return bucket_ < occupied_->GetSize();
     }
 
     bool Next() override {
-        if (chain_it_ == nullptr) {
+        if (!HasNext()) {
             return false;
         }
-        chain_it_->Next();
-        if (chain_it_->HasNext()) {
+        if (++position_ < table_->Get(bucket_)->GetLength()) {
             return true;
         }
-        return AdvanceToNextNonEmptyChain(true);
+        position_ = 0;
+        bucket_ = occupied_->Next(bucket_ + 1);
+        return HasNext();
     }
 
     const KeyValue<Key, Value>& GetCurrentItem() const override {
         if (!HasNext()) {
             throw std::out_of_range("No next element");
         }
-        return *chain_it_->GetCurrentItem();
+        return *table_->Get(bucket_)->Get(position_);
     }
 
     bool TryGetCurrentItem(KeyValue<Key, Value>& element) const override {
         if (!HasNext()) {
             return false;
         }
-        element = *chain_it_->GetCurrentItem();
+        element = *table_->Get(bucket_)->Get(position_);
         return true;
     }
 
 private:
-    bool AdvanceToNextNonEmptyChain(bool move_forward) {
-        if (move_forward && table_it_ != nullptr) {
-            table_it_->Next();
-        }
-        while (table_it_ != nullptr && table_it_->HasNext()) {
-            ChainPtr chain = table_it_->GetCurrentItem();
-            if (chain != nullptr) {
-                chain_it_ = chain->GetIterator();
-                if (chain_it_->HasNext()) {
-                    return true;
-                }
-            }
-            table_it_->Next();
+    SequencePtr<ChainPtr> table_;
+    std::shared_ptr<const OccupancyBitmap> occupied_;
+    size_t bucket_;
+    size_t position_ = 0;
+};
+
+// Walks entries through a sorted array of pointers into the table. The table
+// is kept alive by the iterator, as with HashTableIterator.
+template <typename Key, typename Value>
+class HashTableSortedIterator : public IIterator<KeyValue<Key, Value>> {
+    using Entry = const KeyValue<Key, Value>*;
+
+public:
+    HashTableSortedIterator(std::shared_ptr<const void> table, std::shared_ptr<ArraySequence<Entry>> entries)
+        : table_(std::move(table)), entries_(std::move(entries)) {
+    }
+
+    bool HasNext() const override {
+        return index_ < entries_->GetLength();
+    }
+
+    bool Next() override {
+        if (!HasNext()) {
+            return false;
         }
-        chain_it_.reset();
-        return false;
+        ++index_;
+        return true;
     }
 
-    SequencePtr<ChainPtr> table_;
-    IIteratorPtr<ChainPtr> table_it_;
-    IIteratorPtr<KeyValuePtr> chain_it_;
+    const KeyValue<Key, Value>& GetCurrentItem() const override {
+        if (!HasNext()) {
+            throw std::out_of_range("No next element");
+        }
+        return *entries_->Get(index_);
+    }
+
+    bool TryGetCurrentItem(KeyValue<Key, Value>& element) const override {
+        if (!HasNext()) {
+            return false;
+        }
+        element = *entries_->Get(index_);
+        return true;
+    }
+
+private:
+    std::shared_ptr<const void> table_;
+    std::shared_ptr<ArraySequence<Entry>> entries_;
+    size_t index_ = 0;
 };
 
 template <typename Key, typename Value, typename Hasher = std::hash<Key>>
-class HashTable : public IDictionary<Key, Value> {
+class HashTable : public IDictionary<Key, Value>, public std::enable_shared_from_this<HashTable<Key, Value, Hasher>> {
     using KeyValuePtr = std::shared_ptr<KeyValue<Key, Value>>;
     using ChainPtr = SequencePtr<KeyValuePtr>;
 
@@ -84,14 +179,40 @@ class HashTable : public IDictionary<Key, Value> {
     static constexpr size_t kFactorNominator = 3;
     static constexpr size_t kFactorDenominator = 4;
     static constexpr size_t kScale = 2;
+    // Removals shrink the table by kScale once the load drops below a
+    // quarter of the growth threshold. After the shrink the load is still
+    // at most half of that threshold, so alternating adds and removes
+    // around either boundary do not rehash back and forth.
+    static constexpr size_t kShrinkDivisor = 4;
     static constexpr size_t kMaxChainLength = 10;
+    static constexpr size_t kInlineChainLength = 3;
+    // A long chain only asks for a rehash while the table has fewer than
+    // this many buckets per entry; past that, growing cannot be the cure.
+    static constexpr size_t kMaxBucketsPerEntry = 8;
+    // Chains longer than kMaxChainLength are kept sorted by key and searched
+    // by bisection, which bounds lookups in buckets that rehashing cannot
+    // split (keys with identical hashes). Keys without an order keep linear
+    // chains.
+    static constexpr bool kSortedChains = std::totally_ordered<Key>;
+
+    using Chain = SmallSequence<KeyValuePtr, kInlineChainLength>;
 
 public:
     HashTable(Hasher hasher = Hasher()) : HashTable(kDefaultCapacity, std::move(hasher)) {
     }
 
-    HashTable(size_t capacity, Hasher hasher = Hasher())
-        : table_(std::make_shared<ArraySequence<ChainPtr>>(capacity + 1)), size_(0), hasher_(std::move(hasher)) {
+    explicit HashTable(std::pmr::memory_resource* resource) : HashTable(kDefaultCapacity, Hasher(), resource) {
+    }
+
+    HashTable(size_t capacity, Hasher hasher = Hasher(), std::pmr::memory_resource* resource = DefaultResource())
+        : table_(MakeShared<ArraySequence<ChainPtr>>(resource, capacity + 1, resource)),
+          occupied_(MakeShared<OccupancyBitmap>(resource, capacity + 1, resource)),
+          size_(0),
+          min_capacity_(capacity + 1),
+          base_capacity_(capacity + 1),
+          seed_(NextSeed()),
+          hasher_(std::move(hasher)),
+          resource_(resource) {
     }
 
     size_t GetCount() const override {
@@ -103,151 +224,317 @@ public:
     }
 
     const Value& Get(const Key& key) const override {
-        size_t ind = hasher_(key) % table_->GetLength();
-        ChainPtr chain = table_->Get(ind);
-        if (chain == nullptr) {
+        LAB2_STAT(CountProbe());
+        const ChainPtr& chain = (*table_)[Bucket(key, table_->GetLength())];
+        size_t pos;
+        if (chain == nullptr || !FindInChain(AsChain(chain), key, pos)) {
             throw std::out_of_range("No such key");
         }
-        for (auto it = chain->GetIterator(); it->HasNext(); it->Next()) {
-            auto cur = it->GetCurrentItem();
-            if (cur->key == key) {
-                return cur->value;
-            }
-        }
-        throw std::out_of_range("No such key");
+        return AsChain(chain)[pos]->value;
     }
 
     bool ContainsKey(const Key& key) const override {
-        size_t ind = hasher_(key) % table_->GetLength();
-        ChainPtr chain = table_->Get(ind);
-        if (chain == nullptr) {
-            return false;
-        }
-        for (auto it = chain->GetIterator(); it->HasNext(); it->Next()) {
-            auto cur = it->GetCurrentItem();
-            if (cur->key == key) {
-                return true;
-            }
-        }
-        return false;
+        LAB2_STAT(CountProbe());
+        const ChainPtr& chain = (*table_)[Bucket(key, table_->GetLength())];
+        size_t pos;
+        return chain != nullptr && FindInChain(AsChain(chain), key, pos);
     }
 
     void Add(const Key& key, const Value& value) override {
         Rehash();
-        size_t ind = hasher_(key) % table_->GetLength();
-        ChainPtr chain = table_->Get(ind);
+        LAB2_STAT(CountProbe());
+        size_t ind = Bucket(key, table_->GetLength());
+        ChainPtr chain = (*table_)[ind];
         if (chain == nullptr) {
-            chain = std::make_shared<ListSequence<KeyValuePtr>>();
+            chain = MakeShared<Chain>(resource_, resource_);
             table_->Set(chain, ind);
+            occupied_->Set(ind);
         }
-        for (auto it = chain->GetIterator(); it->HasNext(); it->Next()) {
-            auto cur = it->GetCurrentItem();
-            if (cur->key == key) {
-                cur->value = value;
-                return;
-            }
+        size_t pos;
+        if (FindInChain(AsChain(chain), key, pos)) {
+            AsChain(chain)[pos]->value = value;
+            return;
         }
-        if (chain->GetLength() + 1 >= kMaxChainLength) {
+        auto entry = MakeShared<KeyValue<Key, Value>>(resource_, key, value);
+        size_t length = chain->GetLength();
+        if (IsSplitCheckpoint(length + 1) && CanSplit(AsChain(chain), key)) {
             rehash_requested_ = true;
         }
-        chain->Append(std::make_shared<KeyValue<Key, Value>>(key, value));
+        if constexpr (kSortedChains) {
+            if (length >= kMaxChainLength) {
+                if (length == kMaxChainLength) {
+                    SortChain(*chain);
+                    pos = LowerBound(AsChain(chain), key);
+                }
+                chain->InsertAt(entry, pos);
+                ++size_;
+                return;
+            }
+        }
+        chain->Append(entry);
         ++size_;
     }
 
-    void Remove(const Key& key) override {
-        size_t ind = hasher_(key) % table_->GetLength();
-        ChainPtr chain = table_->Get(ind);
-        if (chain == nullptr) {
-            throw std::out_of_range("No such key");
+    // Grows the bucket array along the usual doubling sequence until `count`
+    // entries fit under the load factor, with a single rehash. Removals do
+    // not shrink the table below the reserved size.
+    void Reserve(size_t count) override {
+        size_t capacity = table_->GetLength();
+        while (count * kFactorDenominator >= capacity * kFactorNominator) {
+            capacity *= kScale;
         }
-        size_t pos = 0;
-        bool found = false;
-        {
-            size_t i = 0;
-            for (auto it = chain->GetIterator(); it->HasNext(); it->Next(), ++i) {
-                auto cur = it->GetCurrentItem();
-                if (cur->key == key) {
-                    pos = i;
-                    found = true;
-                    break;
-                }
-            }
+        if (capacity > table_->GetLength()) {
+            RehashTo(capacity);
         }
-        if (!found) {
+        if (capacity > min_capacity_) {
+            min_capacity_ = capacity;
+        }
+    }
+
+    // Rehashes into the smallest bucket array (no smaller than the one the
+    // table was constructed with) that holds the entries under the load
+    // factor, and drops any reservation.
+    void ShrinkToFit() {
+        size_t capacity = (size_ * kFactorDenominator) / kFactorNominator + 1;
+        if (capacity < base_capacity_) {
+            capacity = base_capacity_;
+        }
+        min_capacity_ = base_capacity_;
+        if (capacity != table_->GetLength()) {
+            RehashTo(capacity);
+        }
+    }
+
+    void Remove(const Key& key) override {
+        LAB2_STAT(CountProbe());
+        size_t ind = Bucket(key, table_->GetLength());
+        ChainPtr chain = (*table_)[ind];
+        size_t pos;
+        if (chain == nullptr || !FindInChain(AsChain(chain), key, pos)) {
             throw std::out_of_range("No such key");
         }
+        // Erasing keeps a sorted chain sorted.
         chain->EraseAt(pos);
         if (chain->GetLength() == 0) {
             table_->Set(ChainPtr{}, ind);
+            occupied_->Clear(ind);
         }
         --size_;
+        Shrink();
     }
 
     SequencePtr<Key> GetKeys() const override {
-        auto res = std::make_shared<ListSequence<Key>>();
-        for (auto it = table_->GetIterator(); it->HasNext(); it->Next()) {
-            auto chain = it->GetCurrentItem();
-            if (chain == nullptr) {
-                continue;
+        return std::make_shared<KeysView<Key, Value>>(ShareOrBorrow(*this));
+    }
+
+    SequencePtr<Value> GetValues() const override {
+        return std::make_shared<ValuesView<Key, Value>>(ShareOrBorrow(*this));
+    }
+
+    IIteratorPtr<KeyValue<Key, Value>> GetIterator() const override {
+        return std::make_shared<HashTableIterator<Key, Value>>(table_, occupied_);
+    }
+
+    // Collects pointers to the entries and sorts them (radix sort for string
+    // keys, parallel merge sort otherwise); entries are not copied.
+    IIteratorPtr<KeyValue<Key, Value>> GetSortedIterator() const override {
+        using Entry = const KeyValue<Key, Value>*;
+        auto entries = std::make_shared<ArraySequence<Entry>>(size_);
+        Entry* out = entries->GetBegin();
+        ForEachEntry([&](const KeyValuePtr& item) { *out++ = item.get(); });
+        using Less = KeyPtrLess<Key, Value>;
+        if constexpr (StringSortKey<Entry, Less>::kEnabled) {
+            StringRadixSort<Entry, Less>(entries->GetBegin(), size_);
+        } else {
+            ParallelMergeSort(entries->GetBegin(), size_, Less());
+        }
+        return std::make_shared<HashTableSortedIterator<Key, Value>>(table_, std::move(entries));
+    }
+
+    HashTableStats GetStats() const {
+        HashTableStats stats;
+#ifdef LAB2_STATS
+        stats = stats_;
+#endif
+        size_t used = 0;
+        ForEachChain([&](const Sequence<KeyValuePtr>& chain) {
+            size_t length = chain.GetLength();
+            ++stats.chain_lengths[length < kChainHistogramSize ? length : kChainHistogramSize - 1];
+            ++used;
+        });
+        stats.chain_lengths[0] += table_->GetLength() - used;
+        return stats;
+    }
+
+    void ResetStats() {
+#ifdef LAB2_STATS
+        stats_ = HashTableStats{};
+#endif
+    }
+
+private:
+#ifdef LAB2_STATS
+    void CountProbe() const {
+        ++stats_.lookup.lookups;
+        ++stats_.lookup.probes;
+    }
+#endif
+
+    // Visits the non-empty chains, skipping empty buckets through the
+    // occupancy bitmap.
+    template <typename Visit>
+    void ForEachChain(Visit&& visit) const {
+        const size_t capacity = table_->GetLength();
+        for (size_t ind = occupied_->Next(0); ind < capacity; ind = occupied_->Next(ind + 1)) {
+            visit(static_cast<Chain&>(*(*table_)[ind]));
+        }
+    }
+
+    template <typename Visit>
+    void ForEachEntry(Visit&& visit) const {
+        ForEachChain([&](const Chain& chain) {
+            for (size_t i = 0; i < chain.GetLength(); ++i) {
+                visit(chain[i]);
+            }
+        });
+    }
+
+    // Every bucket holds a Chain; going through the concrete type keeps the
+    // chain scans free of virtual calls.
+    static const Chain& AsChain(const ChainPtr& chain) {
+        return static_cast<const Chain&>(*chain);
+    }
+
+    static uint64_t NextSeed() {
+        static std::atomic<uint64_t> counter{0};
+        return MixHash(counter.fetch_add(1, std::memory_order_relaxed) + 0x9e3779b97f4a7c15ULL);
+    }
+
+    size_t Bucket(const Key& key, size_t capacity) const {
+        return MixHash(static_cast<uint64_t>(hasher_(key)) ^ seed_) % capacity;
+    }
+
+    // Finds `key` in the chain; on a miss `pos` is where a sorted chain would
+    // take it.
+    bool FindInChain(const Chain& chain, const Key& key, size_t& pos) const {
+        size_t length = chain.GetLength();
+        if constexpr (kSortedChains) {
+            if (length > kMaxChainLength) {
+                pos = LowerBound(chain, key);
+                return pos < length && chain[pos]->key == key;
             }
-            for (auto chain_it = chain->GetIterator(); chain_it->HasNext(); chain_it->Next()) {
-                auto item = chain_it->GetCurrentItem();
-                res->Append(item->key);
+        }
+        for (pos = 0; pos < length; ++pos) {
+            LAB2_STAT(++stats_.lookup.comparisons);
+            if (chain[pos]->key == key) {
+                return true;
             }
         }
-        return res;
+        return false;
     }
 
-    SequencePtr<Value> GetValues() const override {
-        auto res = std::make_shared<ListSequence<Value>>();
-        for (auto it = table_->GetIterator(); it->HasNext(); it->Next()) {
-            auto chain = it->GetCurrentItem();
-            if (chain == nullptr) {
-                continue;
-            }
-            for (auto chain_it = chain->GetIterator(); chain_it->HasNext(); chain_it->Next()) {
-                auto item = chain_it->GetCurrentItem();
-                res->Append(item->value);
+    size_t LowerBound(const Chain& chain, const Key& key) const {
+        size_t lo = 0;
+        size_t hi = chain.GetLength();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            LAB2_STAT(++stats_.lookup.comparisons);
+            if (chain[mid]->key < key) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
             }
         }
-        return res;
+        return lo;
     }
 
-    IIteratorPtr<KeyValue<Key, Value>> GetIterator() const override {
-        return std::make_shared<HashTableIterator<Key, Value>>(table_);
+    void SortChain(Sequence<KeyValuePtr>& chain) const {
+        ArraySequence<KeyValuePtr> items(chain);
+        ParallelMergeSort(items.GetBegin(), items.GetLength(),
+                          [](const KeyValuePtr& a, const KeyValuePtr& b) { return a->key < b->key; });
+        for (size_t i = 0; i < items.GetLength(); ++i) {
+            chain.Set(items[i], i);
+        }
+    }
+
+    // Chain lengths at which Add asks CanSplit: kMaxChainLength and its
+    // doublings. The answer only changes as the chain grows, so it holds
+    // until the chain doubles; asking on every insert would rehash the whole
+    // chain each time and make a build under collisions quadratic.
+    static bool IsSplitCheckpoint(size_t length) {
+        return length % kMaxChainLength == 0 && std::has_single_bit(length / kMaxChainLength);
+    }
+
+    // Whether growing the table can shorten the chain that `key` is about to
+    // join: not when most of it shares the key's full hash, and not once the
+    // table is already much larger than its contents.
+    bool CanSplit(const Chain& chain, const Key& key) const {
+        if (table_->GetLength() >= kMaxBucketsPerEntry * (size_ + 1)) {
+            return false;
+        }
+        size_t hash = hasher_(key);
+        size_t same = 1;
+        for (size_t i = 0; i < chain.GetLength(); ++i) {
+            same += hasher_(chain[i]->key) == hash ? 1 : 0;
+        }
+        return 2 * same <= chain.GetLength() + 1;
     }
 
-private:
     void Rehash() {
         bool need_rehash = rehash_requested_ || (size_ * kFactorDenominator >= table_->GetLength() * kFactorNominator);
         if (!need_rehash) {
             return;
         }
-        size_t new_capacity = kScale * table_->GetLength();
-        auto new_table = std::make_shared<ArraySequence<ChainPtr>>(new_capacity);
-        for (auto it = table_->GetIterator(); it->HasNext(); it->Next()) {
-            auto chain = it->GetCurrentItem();
-            if (chain == nullptr) {
-                continue;
+        RehashTo(kScale * table_->GetLength());
+    }
+
+    void Shrink() {
+        size_t capacity = table_->GetLength();
+        if (capacity / kScale < min_capacity_ ||
+            size_ * kFactorDenominator * kShrinkDivisor >= capacity * kFactorNominator) {
+            return;
+        }
+        RehashTo(capacity / kScale);
+    }
+
+    void RehashTo(size_t new_capacity) {
+        LAB2_STAT(++stats_.rehashes);
+        LAB2_STAT(StatTimer timer(stats_.rehash_ns));
+        auto new_table = MakeShared<ArraySequence<ChainPtr>>(resource_, new_capacity, resource_);
+        auto new_occupied = MakeShared<OccupancyBitmap>(resource_, new_capacity, resource_);
+        ForEachEntry([&](const KeyValuePtr& item) {
+            auto ind = Bucket(item->key, new_capacity);
+            ChainPtr dest_chain = (*new_table)[ind];
+            if (dest_chain == nullptr) {
+                dest_chain = MakeShared<Chain>(resource_, resource_);
+                new_table->Set(dest_chain, ind);
+                new_occupied->Set(ind);
             }
-            for (auto chain_it = chain->GetIterator(); chain_it->HasNext(); chain_it->Next()) {
-                auto item = chain_it->GetCurrentItem();
-                auto ind = hasher_(item->key) % new_capacity;
-                ChainPtr dest_chain = new_table->Get(ind);
-                if (dest_chain == nullptr) {
-                    dest_chain = std::make_shared<ListSequence<KeyValuePtr>>();
-                    new_table->Set(dest_chain, ind);
+            dest_chain->Append(item);
+        });
+        table_ = new_table;
+        occupied_ = new_occupied;
+        if constexpr (kSortedChains) {
+            ForEachChain([&](Sequence<KeyValuePtr>& chain) {
+                if (chain.GetLength() > kMaxChainLength) {
+                    SortChain(chain);
                 }
-                dest_chain->Append(std::move(item));
-            }
+            });
         }
-        table_ = new_table;
         rehash_requested_ = false;
     }
 
 private:
-    SequencePtr<ChainPtr> table_;
+    std::shared_ptr<ArraySequence<ChainPtr>> table_;
+    std::shared_ptr<OccupancyBitmap> occupied_;
     size_t size_;
+    size_t min_capacity_;
+    size_t base_capacity_;
     bool rehash_requested_ = false;
+    uint64_t seed_;
     const Hasher hasher_;
+    std::pmr::memory_resource* resource_;
+#ifdef LAB2_STATS
+    mutable HashTableStats stats_;
+#endif
 };
@@ -13,6 +13,21 @@ struct KeyValue {
     }
 };
 
+template <typename Key, typename Value>
+struct KeyLess {
+    bool operator()(const KeyValue<Key, Value>& a, const KeyValue<Key, Value>& b) const {
+        return a.key < b.key;
+    }
+};
+
+// Orders entries held by pointer, for sorting views over a dictionary.
+template <typename Key, typename Value>
+struct KeyPtrLess {
+    bool operator()(const KeyValue<Key, Value>* a, const KeyValue<Key, Value>* b) const {
+        return a->key < b->key;
+    }
+};
+
 template <typename Key, typename Value>
 class IDictionary : public IIterable<KeyValue<Key, Value>> {
 public:
@@ -26,6 +41,19 @@ public:
     virtual void Add(const Key& key, const Value& value) = 0;
     virtual void Remove(const Key& key) = 0;
 
+    // Sizes the dictionary for `count` entries so that filling it does not
+    // regrow; a no-op where there is nothing to pre-size.
+    virtual void Reserve(size_t) {
+    }
+
+    // Read-only sequences in iteration order (sequence_view.hpp). A view
+    // keeps a dictionary held by shared_ptr alive; one that is not must
+    // outlive it. Views that read the dictionary in place are valid until it
+    // changes; array-backed ones take a snapshot. Materialize() copies out.
     virtual SequencePtr<Key> GetKeys() const = 0;
     virtual SequencePtr<Value> GetValues() const = 0;
+
+    // Entries in ascending key order. Ordered backends return GetIterator();
+    // the others sort a view of their entries without copying them.
+    virtual IIteratorPtr<KeyValue<Key, Value>> GetSortedIterator() const = 0;
 };
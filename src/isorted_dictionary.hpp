@@ -0,0 +1,35 @@
+#pragma once
+
+#include <concepts>
+#include <string>
+
+#include "fwd.hpp"
+#include "idictionary.hpp"
+
+template <typename Key, typename Value>
+class ISortedDictionary : public IDictionary<Key, Value> {
+public:
+    // Entries with lo <= key < hi in ascending key order.
+    virtual IIteratorPtr<KeyValue<Key, Value>> Range(const Key& lo, const Key& hi) const = 0;
+
+    // Entries with key >= lo in ascending key order.
+    virtual IIteratorPtr<KeyValue<Key, Value>> RangeFrom(const Key& lo) const = 0;
+
+    IIteratorPtr<KeyValue<Key, Value>> GetSortedIterator() const override {
+        return this->GetIterator();
+    }
+
+    IIteratorPtr<KeyValue<Key, Value>> ScanPrefix(const Key& prefix) const
+        requires std::same_as<Key, std::string>
+    {
+        std::string hi = prefix;
+        while (!hi.empty() && static_cast<unsigned char>(hi.back()) == 0xFF) {
+            hi.pop_back();
+        }
+        if (hi.empty()) {
+            return RangeFrom(prefix);
+        }
+        hi.back() = static_cast<char>(static_cast<unsigned char>(hi.back()) + 1);
+        return Range(prefix, hi);
+    }
+};
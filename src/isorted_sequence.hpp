@@ -20,6 +20,10 @@ public:
 
     virtual size_t LowerBound(const T& value) const = 0;
 
+    // Iterates over positions [begin, end) without copying the elements.
+    virtual IIteratorPtr<T> GetRangeIterator(size_t begin, size_t end) const = 0;
+
+    virtual void Reserve(size_t capacity) = 0;
     virtual void Add(const T& value) = 0;
     virtual void EraseAt(size_t index) = 0;
     virtual void Clear() = 0;
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <memory>
+#include <memory_resource>
 #include <stdexcept>
 #include <string>
 
+#include "bounds_check.hpp"
+#include "memory.hpp"
+
 template <typename T>
 struct ListNode;
 
@@ -30,7 +34,8 @@ struct ListNode : public std::enable_shared_from_this<ListNode<T>> {
 template <typename T>
 class LinkedList {
 public:
-    LinkedList(const T* items, size_t count) {
+    LinkedList(const T* items, size_t count, std::pmr::memory_resource* resource = DefaultResource())
+        : resource_(resource) {
         for (size_t i = 0; i < count; ++i) {
             Append(items[i]);
         }
@@ -39,6 +44,9 @@ public:
     LinkedList() {
     }
 
+    explicit LinkedList(std::pmr::memory_resource* resource) : resource_(resource) {
+    }
+
     LinkedList(const LinkedList<T>& l) {
         ListNodePtr<T> cur = l.first_;
         for (size_t i = 0; i < l.size_; ++i) {
@@ -62,16 +70,12 @@ public:
     }
 
     const T& Get(size_t index) const {
-        if (index >= size_) {
-            throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
-        }
+        CheckIndex(index, size_);
         return first_->NextNth(index)->value;
     }
 
     void Set(const T& item, size_t index) {
-        if (index >= size_) {
-            throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
-        }
+        CheckIndex(index, size_);
         first_->NextNth(index)->value = item;
     }
 
@@ -100,7 +104,7 @@ public:
     }
 
     void Append(const T& item) {
-        ListNodePtr<T> cur = std::make_shared<ListNode<T>>(item);
+        ListNodePtr<T> cur = MakeShared<ListNode<T>>(resource_, item);
         if (size_ == 0) {
             first_ = cur;
             last_ = cur;
@@ -113,7 +117,7 @@ public:
     }
 
     void Prepend(const T& item) {
-        ListNodePtr<T> cur = std::make_shared<ListNode<T>>(item);
+        ListNodePtr<T> cur = MakeShared<ListNode<T>>(resource_, item);
         if (size_ == 0) {
             first_ = cur;
             last_ = cur;
@@ -128,7 +132,7 @@ public:
     // Insert before index
     void InsertAt(const T& item, size_t index) {
         if (index > size_) {
-            throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
+            ThrowIndexOutOfRange(index, size_);
         }
         if (index == size_) {
             Append(item);
@@ -140,7 +144,7 @@ public:
         }
         ListNodePtr<T> prev = first_->NextNth(index - 1);
         ListNodePtr<T> next = prev->next;
-        ListNodePtr<T> cur = std::make_shared<ListNode<T>>(item);
+        ListNodePtr<T> cur = MakeShared<ListNode<T>>(resource_, item);
         prev->next = cur;
         cur->next = next;
         ++size_;
@@ -163,9 +167,7 @@ public:
     }
 
     void EraseAt(size_t index) {
-        if (index >= size_) {
-            throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
-        }
+        CheckIndex(index, size_);
         if (index == 0) {
             first_ = first_->next;
             if (size_ == 1) {
@@ -193,4 +195,5 @@ private:
     ListNodePtr<T> first_;
     ListNodePtr<T> last_;
     size_t size_ = 0;
+    std::pmr::memory_resource* resource_ = DefaultResource();
 };
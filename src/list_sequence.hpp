@@ -61,6 +61,9 @@ public:
     ListSequence() {
     }
 
+    explicit ListSequence(std::pmr::memory_resource* resource) : data_(resource) {
+    }
+
     const T& GetFirst() const override {
         return data_.GetFirst();
     }
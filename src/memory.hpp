@@ -0,0 +1,17 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+// Containers take an optional std::pmr::memory_resource and allocate their
+// buffers, nodes and control blocks from it. Passing a monotonic arena lets a
+// whole structure be released at once when the arena goes away.
+inline std::pmr::memory_resource* DefaultResource() {
+    return std::pmr::get_default_resource();
+}
+
+template <typename T, typename... Args>
+std::shared_ptr<T> MakeShared(std::pmr::memory_resource* resource, Args&&... args) {
+    return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(resource), std::forward<Args>(args)...);
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "dynamic_array.hpp"
+
+inline std::atomic<size_t> g_thread_count{0};
+
+// Number of worker threads used by parallel algorithms; 0 restores the
+// default of one thread per hardware core.
+inline void SetThreadCount(size_t count) {
+    g_thread_count = count;
+}
+
+inline size_t GetThreadCount() {
+    size_t count = g_thread_count;
+    if (count == 0) {
+        count = std::thread::hardware_concurrency();
+    }
+    return count == 0 ? 1 : count;
+}
+
+// Worker threads kept for the life of the program, so that ParallelFor,
+// which runs once per merge pass, does not start and join threads each time.
+// Workers are started on first use, as many as a run has asked for so far.
+class ThreadPool {
+public:
+    static ThreadPool& Instance() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    // Runs job(id) for every id in [0, count) and returns once all are done;
+    // job must not throw. The caller runs id 0 and whatever ids the workers
+    // cannot take: all of them when a thread cannot be started, when another
+    // run is in progress, or when called from a worker (nested runs).
+    void Run(size_t count, const std::function<void(size_t)>& job) {
+        std::unique_lock<std::mutex> busy(run_mutex_, std::try_to_lock);
+        if (!busy.owns_lock() || is_worker_) {
+            for (size_t id = 0; id < count; ++id) {
+                job(id);
+            }
+            return;
+        }
+        size_t helpers = Grow(count - 1);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            helpers_ = helpers;
+            pending_ = helpers;
+            ++generation_;
+        }
+        wake_.notify_all();
+        job(0);
+        for (size_t id = helpers + 1; id < count; ++id) {
+            job(id);
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+        job_ = nullptr;
+    }
+
+private:
+    ThreadPool() = default;
+
+    // Starts workers until there are `wanted`; returns how many there are
+    // now, which is fewer if the system refuses another thread.
+    size_t Grow(size_t wanted) {
+        while (workers_.size() < wanted) {
+            try {
+                workers_.emplace_back(&ThreadPool::Work, this, workers_.size() + 1, generation_);
+            } catch (const std::system_error&) {
+                break;
+            }
+        }
+        return workers_.size() < wanted ? workers_.size() : wanted;
+    }
+
+    void Work(size_t id, uint64_t generation) {
+        is_worker_ = true;
+        while (true) {
+            const std::function<void(size_t)>* job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stop_ || generation_ != generation; });
+                if (stop_) {
+                    return;
+                }
+                generation = generation_;
+                if (id > helpers_) {
+                    continue;
+                }
+                job = job_;
+            }
+            (*job)(id);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    static inline thread_local bool is_worker_ = false;
+
+    std::mutex run_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::vector<std::thread> workers_;
+    const std::function<void(size_t)>* job_ = nullptr;
+    size_t helpers_ = 0;
+    size_t pending_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+// Runs body(task) for every task in [0, tasks), distributing the tasks
+// round-robin over up to `threads` threads of the ThreadPool. The calling
+// thread takes part. The first exception thrown by any task is rethrown
+// once all of them have finished.
+template <typename Body>
+void ParallelFor(size_t tasks, size_t threads, Body&& body) {
+    if (threads > tasks) {
+        threads = tasks;
+    }
+    if (threads <= 1) {
+        for (size_t task = 0; task < tasks; ++task) {
+            body(task);
+        }
+        return;
+    }
+    DynamicArray<std::exception_ptr> errors(threads);
+    ThreadPool::Instance().Run(threads, [&](size_t id) {
+        try {
+            for (size_t task = id; task < tasks; task += threads) {
+                body(task);
+            }
+        } catch (...) {
+            errors.Set(std::current_exception(), id);
+        }
+    });
+    for (size_t id = 0; id < threads; ++id) {
+        if (errors.Get(id)) {
+            std::rethrow_exception(errors.Get(id));
+        }
+    }
+}
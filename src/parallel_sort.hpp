@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+#include "array_sequence.hpp"
+#include "dynamic_array.hpp"
+#include "parallel.hpp"
+
+namespace sort_detail {
+
+constexpr size_t kRunSize = 32;
+constexpr size_t kMinMergeChunk = 1 << 12;
+constexpr size_t kParallelThreshold = 1 << 13;
+
+template <typename T, typename Comparator>
+void InsertionSort(T* data, size_t n, const Comparator& comp) {
+    for (size_t i = 1; i < n; ++i) {
+        if (!comp(data[i], data[i - 1])) {
+            continue;
+        }
+        T value = std::move(data[i]);
+        size_t j = i;
+        while (j > 0 && comp(value, data[j - 1])) {
+            data[j] = std::move(data[j - 1]);
+            --j;
+        }
+        data[j] = std::move(value);
+    }
+}
+
+// How many of the first k elements of the stable merge of a and b come from a.
+template <typename T, typename Comparator>
+size_t MergeSplit(const T* a, size_t na, const T* b, size_t nb, size_t k, const Comparator& comp) {
+    size_t lo = k > nb ? k - nb : 0;
+    size_t hi = std::min(k, na);
+    while (lo < hi) {
+        size_t i = (lo + hi) / 2;
+        if (!comp(b[k - i - 1], a[i])) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+// Writes output positions [k0, k1) of the stable merge of a and b to out.
+template <typename T, typename Comparator>
+void MergeWindow(T* a, size_t na, T* b, size_t nb, T* out, size_t k0, size_t k1, const Comparator& comp) {
+    size_t i = MergeSplit(a, na, b, nb, k0, comp);
+    size_t j = k0 - i;
+    size_t i_end = MergeSplit(a, na, b, nb, k1, comp);
+    size_t j_end = k1 - i_end;
+    T* dst = out + k0;
+    while (i < i_end && j < j_end) {
+        if (comp(b[j], a[i])) {
+            *dst++ = std::move(b[j++]);
+        } else {
+            *dst++ = std::move(a[i++]);
+        }
+    }
+    dst = std::move(a + i, a + i_end, dst);
+    std::move(b + j, b + j_end, dst);
+}
+
+struct MergeTask {
+    size_t begin = 0;
+    size_t mid = 0;
+    size_t end = 0;
+    size_t k0 = 0;
+    size_t k1 = 0;
+};
+
+}  // namespace sort_detail
+
+// Stable bottom-up merge sort. Runs of kRunSize elements are insertion-sorted,
+// then merged pass by pass between data and one scratch buffer, moving
+// elements instead of copying them. Every pass is cut into output windows of
+// similar size (splitting large merges along the merge path) and the windows
+// are merged on up to `threads` threads.
+template <typename T, typename Comparator>
+void ParallelMergeSort(T* data, size_t n, const Comparator& comp, size_t threads = GetThreadCount()) {
+    using namespace sort_detail;
+    if (n < 2) {
+        return;
+    }
+    if (n < kParallelThreshold) {
+        threads = 1;
+    }
+    size_t runs = (n + kRunSize - 1) / kRunSize;
+    ParallelFor(runs, threads, [&](size_t run) {
+        size_t begin = run * kRunSize;
+        InsertionSort(data + begin, std::min(kRunSize, n - begin), comp);
+    });
+    if (runs == 1) {
+        return;
+    }
+
+    DynamicArray<T> buffer(n);
+    T* src = data;
+    T* dst = buffer.GetBegin();
+    const size_t chunk = std::max(kMinMergeChunk, (n + threads - 1) / threads);
+    for (size_t width = kRunSize; width < n; width *= 2) {
+        ArraySequence<MergeTask> tasks;
+        for (size_t begin = 0; begin < n; begin += 2 * width) {
+            size_t mid = std::min(begin + width, n);
+            size_t end = std::min(begin + 2 * width, n);
+            for (size_t k0 = 0; k0 < end - begin; k0 += chunk) {
+                tasks.Append(MergeTask{begin, mid, end, k0, std::min(k0 + chunk, end - begin)});
+            }
+        }
+        ParallelFor(tasks.GetLength(), threads, [&](size_t t) {
+            const MergeTask& task = tasks[t];
+            MergeWindow(src + task.begin, task.mid - task.begin, src + task.mid, task.end - task.mid,
+                        dst + task.begin, task.k0, task.k1, comp);
+        });
+        std::swap(src, dst);
+    }
+    if (src != data) {
+        size_t pieces = (n + chunk - 1) / chunk;
+        ParallelFor(pieces, threads, [&](size_t piece) {
+            size_t begin = piece * chunk;
+            std::move(src + begin, src + std::min(begin + chunk, n), data + begin);
+        });
+    }
+}
@@ -0,0 +1,465 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "array_sequence.hpp"
+#include "dynamic_array.hpp"
+#include "hash_table.hpp"
+#include "idictionary.hpp"
+#include "parallel_sort.hpp"
+#include "sequence_view.hpp"
+#include "stats.hpp"
+
+// Seeded 64-bit string hash, eight bytes per mixing round. Keys are read in
+// native byte order, so serialized tables are tied to the byte order of the
+// machine that froze them.
+inline uint64_t HashKey(std::string_view key, uint64_t seed) {
+    uint64_t h = seed ^ (key.size() * 0x9e3779b97f4a7c15ULL);
+    size_t i = 0;
+    for (; i + 8 <= key.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, key.data() + i, 8);
+        h = MixHash(h ^ word);
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, key.data() + i, key.size() - i);
+    return MixHash(h ^ tail);
+}
+
+// The arrays of a frozen table. Entries are stored by position (0..count-1):
+// key bytes back to back with an offset table, values alongside.
+template <typename Value>
+struct PerfectHashStorage {
+    uint64_t seed = 0;
+    size_t count = 0;
+    size_t slots = 0;
+    DynamicArray<uint16_t> pilots;
+    DynamicArray<uint32_t> remap;  // positions of slots >= count
+    DynamicArray<uint32_t> offsets;
+    DynamicArray<char> keys;
+    DynamicArray<Value> values;
+
+    std::string_view KeyAt(size_t pos) const {
+        const uint32_t* off = offsets.GetBegin();
+        return std::string_view(keys.GetBegin() + off[pos], off[pos + 1] - off[pos]);
+    }
+};
+
+// Walks a frozen table in position order, or in the order given by `order`.
+template <typename Value>
+class PerfectHashTableIterator : public IIterator<KeyValue<std::string, Value>> {
+    using Storage = PerfectHashStorage<Value>;
+
+public:
+    PerfectHashTableIterator(std::shared_ptr<const Storage> data, std::shared_ptr<ArraySequence<uint32_t>> order)
+        : data_(std::move(data)), order_(std::move(order)) {
+        Update();
+    }
+
+    bool HasNext() const override {
+        return index_ < data_->count;
+    }
+
+    bool Next() override {
+        if (!HasNext()) {
+            return false;
+        }
+        ++index_;
+        Update();
+        return true;
+    }
+
+    const KeyValue<std::string, Value>& GetCurrentItem() const override {
+        if (!HasNext()) {
+            throw std::out_of_range("No next element");
+        }
+        return current_;
+    }
+
+    bool TryGetCurrentItem(KeyValue<std::string, Value>& element) const override {
+        if (!HasNext()) {
+            return false;
+        }
+        element = current_;
+        return true;
+    }
+
+private:
+    void Update() {
+        if (HasNext()) {
+            size_t pos = order_ == nullptr ? index_ : order_->Get(index_);
+            current_.key = data_->KeyAt(pos);
+            current_.value = data_->values[pos];
+        }
+    }
+
+    std::shared_ptr<const Storage> data_;
+    std::shared_ptr<ArraySequence<uint32_t>> order_;
+    size_t index_ = 0;
+    KeyValue<std::string, Value> current_;
+};
+
+// Immutable minimal perfect hash table over string keys, built PtrHash-style.
+// Keys are split into small buckets by hash; every bucket gets a 16-bit
+// pilot, found by trial, that sends all of its keys to distinct free slots
+// of an array slightly larger than the key count. The few keys that land
+// past the end are remapped into the holes left below it, so positions are
+// exactly 0..count-1. A lookup hashes the key, reads one pilot and compares
+// against the key stored at the resulting position; there are no chains and
+// no load-factor slack.
+template <typename Value>
+class PerfectHashTable : public IDictionary<std::string, Value> {
+    using Pair = KeyValue<std::string, Value>;
+    using Storage = PerfectHashStorage<Value>;
+
+    static constexpr size_t kKeysPerBucket = 3;
+    static constexpr size_t kSlackDivisor = 50;  // slots = count + count / 50 + 1
+    static constexpr size_t kMaxPilot = UINT16_MAX;
+    static constexpr size_t kMaxAttempts = 16;
+    static constexpr char kMagic[8] = {'L', 'A', 'B', '2', 'P', 'H', 'T', '1'};
+
+public:
+    using Staging = HashTable<std::string, Value>;
+
+    explicit PerfectHashTable(const IDictionary<std::string, Value>& source) {
+        auto data = std::make_shared<Storage>();
+        data->count = source.GetCount();
+        // Copied: iterators over frozen backends reuse one current item.
+        ArraySequence<Pair> entries(data->count);
+        size_t i = 0;
+        for (auto it = source.GetIterator(); it->HasNext(); it->Next()) {
+            entries.Set(it->GetCurrentItem(), i++);
+        }
+        for (size_t attempt = 0;; ++attempt) {
+            if (attempt == kMaxAttempts) {
+                throw std::runtime_error("PerfectHashTable: no pilots found");
+            }
+            data->seed = MixHash(attempt + 0x9e3779b97f4a7c15ULL);
+            if (Build(entries, *data)) {
+                break;
+            }
+        }
+        data_ = std::move(data);
+    }
+
+    size_t GetCount() const override {
+        return data_->count;
+    }
+
+    size_t GetCapacity() const override {
+        return data_->count;
+    }
+
+    size_t GetByteSize() const {
+        return data_->pilots.GetSize() * sizeof(uint16_t) + data_->remap.GetSize() * sizeof(uint32_t) +
+               data_->offsets.GetSize() * sizeof(uint32_t) + data_->keys.GetSize() +
+               data_->values.GetSize() * sizeof(Value);
+    }
+
+    const Value& Get(const std::string& key) const override {
+        size_t pos = Find(key);
+        if (pos == data_->count) {
+            throw std::out_of_range("No such key");
+        }
+        return data_->values[pos];
+    }
+
+    bool ContainsKey(const std::string& key) const override {
+        return Find(key) != data_->count;
+    }
+
+    void Add(const std::string&, const Value&) override {
+        throw std::logic_error("PerfectHashTable is immutable");
+    }
+
+    void Remove(const std::string&) override {
+        throw std::logic_error("PerfectHashTable is immutable");
+    }
+
+    SequencePtr<std::string> GetKeys() const override {
+        return CopyKeys(*this);
+    }
+
+    SequencePtr<Value> GetValues() const override {
+        return std::make_shared<ArrayView<Value>>(data_->values.GetBegin(), data_->count, data_);
+    }
+
+    IIteratorPtr<Pair> GetIterator() const override {
+        return std::make_shared<PerfectHashTableIterator<Value>>(data_, nullptr);
+    }
+
+    IIteratorPtr<Pair> GetSortedIterator() const override {
+        auto order = std::make_shared<ArraySequence<uint32_t>>(data_->count);
+        for (size_t pos = 0; pos < data_->count; ++pos) {
+            order->GetBegin()[pos] = static_cast<uint32_t>(pos);
+        }
+        const Storage& data = *data_;
+        ParallelMergeSort(order->GetBegin(), data.count,
+                          [&data](uint32_t a, uint32_t b) { return data.KeyAt(a) < data.KeyAt(b); });
+        return std::make_shared<PerfectHashTableIterator<Value>>(data_, std::move(order));
+    }
+
+    // Binary image of the table in native byte order: a magic tag, the
+    // sizes, then every array as stored. Returns false if the stream fails.
+    bool Serialize(std::ostream& out) const
+        requires std::is_trivially_copyable_v<Value>
+    {
+        const Storage& data = *data_;
+        out.write(kMagic, sizeof(kMagic));
+        uint64_t header[5] = {data.seed, data.count, data.slots, data.pilots.GetSize(), data.keys.GetSize()};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        WriteArray(out, data.pilots);
+        WriteArray(out, data.remap);
+        WriteArray(out, data.offsets);
+        WriteArray(out, data.keys);
+        WriteArray(out, data.values);
+        return static_cast<bool>(out);
+    }
+
+    // Reads a table written by Serialize; nullptr if the image is truncated
+    // or inconsistent.
+    static std::shared_ptr<PerfectHashTable> Deserialize(std::istream& in)
+        requires std::is_trivially_copyable_v<Value>
+    {
+        char magic[sizeof(kMagic)];
+        uint64_t header[5];
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+            !in.read(reinterpret_cast<char*>(header), sizeof(header))) {
+            return nullptr;
+        }
+        auto data = std::make_shared<Storage>();
+        data->seed = header[0];
+        data->count = header[1];
+        data->slots = header[2];
+        if (data->count > data->slots || data->count > UINT32_MAX || (data->count > 0 && header[3] == 0)) {
+            return nullptr;
+        }
+        if (!ReadArray(in, data->pilots, header[3]) || !ReadArray(in, data->remap, data->slots - data->count) ||
+            !ReadArray(in, data->offsets, data->count + 1) || !ReadArray(in, data->keys, header[4]) ||
+            !ReadArray(in, data->values, data->count)) {
+            return nullptr;
+        }
+        const uint32_t* offsets = data->offsets.GetBegin();
+        if (offsets[0] != 0 || offsets[data->count] != header[4]) {
+            return nullptr;
+        }
+        for (size_t pos = 0; pos < data->count; ++pos) {
+            if (offsets[pos] > offsets[pos + 1]) {
+                return nullptr;
+            }
+        }
+        for (size_t i = 0; i < data->remap.GetSize() && data->count > 0; ++i) {
+            if (data->remap.Get(i) >= data->count) {
+                return nullptr;
+            }
+        }
+        return std::shared_ptr<PerfectHashTable>(new PerfectHashTable(std::move(data)));
+    }
+
+    LookupStats GetStats() const {
+#ifdef LAB2_STATS
+        return stats_;
+#else
+        return LookupStats{};
+#endif
+    }
+
+    void ResetStats() {
+#ifdef LAB2_STATS
+        stats_ = LookupStats{};
+#endif
+    }
+
+private:
+    explicit PerfectHashTable(std::shared_ptr<const Storage> data) : data_(std::move(data)) {
+    }
+
+    static uint64_t PilotHash(uint64_t pilot) {
+        return (pilot + 1) * 0x9e3779b97f4a7c15ULL;
+    }
+
+    static size_t Slot(uint64_t hash, uint64_t pilot, size_t slots) {
+        return MixHash(hash ^ PilotHash(pilot)) % slots;
+    }
+
+    size_t Find(std::string_view key) const {
+        const Storage& data = *data_;
+        LAB2_STAT(++stats_.lookups);
+        if (data.count == 0) {
+            return 0;
+        }
+        uint64_t hash = HashKey(key, data.seed);
+        size_t pos = Slot(hash, data.pilots.GetBegin()[hash % data.pilots.GetSize()], data.slots);
+        if (pos >= data.count) {
+            pos = data.remap.GetBegin()[pos - data.count];
+        }
+        LAB2_STAT(++stats_.probes);
+        LAB2_STAT(++stats_.comparisons);
+        return data.KeyAt(pos) == key ? pos : data.count;
+    }
+
+    // One build attempt with data.seed; false if some bucket finds no pilot
+    // (or two keys share a full hash), and the caller retries with a new seed.
+    static bool Build(const ArraySequence<Pair>& entries, Storage& data) {
+        const size_t count = data.count;
+        const size_t buckets = count / kKeysPerBucket + 1;
+        data.slots = count + count / kSlackDivisor + 1;
+
+        // Counting sort of the keys by bucket.
+        DynamicArray<uint64_t> hashes(count);
+        DynamicArray<uint32_t> bucket_start(buckets + 1);
+        uint32_t* start = bucket_start.GetBegin();
+        std::memset(start, 0, (buckets + 1) * sizeof(uint32_t));
+        for (size_t i = 0; i < count; ++i) {
+            hashes.GetBegin()[i] = HashKey(entries.Get(i).key, data.seed);
+            ++start[hashes.GetBegin()[i] % buckets + 1];
+        }
+        size_t max_size = 0;
+        for (size_t b = 0; b < buckets; ++b) {
+            max_size = start[b + 1] > max_size ? start[b + 1] : max_size;
+            start[b + 1] += start[b];
+        }
+        DynamicArray<uint32_t> members(count);
+        {
+            DynamicArray<uint32_t> fill(bucket_start);
+            for (size_t i = 0; i < count; ++i) {
+                members.GetBegin()[fill.GetBegin()[hashes.GetBegin()[i] % buckets]++] = static_cast<uint32_t>(i);
+            }
+        }
+
+        // Largest buckets first, while the slot array is still empty.
+        DynamicArray<uint32_t> by_size(buckets);
+        {
+            DynamicArray<uint32_t> size_start(max_size + 2);
+            std::memset(size_start.GetBegin(), 0, (max_size + 2) * sizeof(uint32_t));
+            for (size_t b = 0; b < buckets; ++b) {
+                ++size_start.GetBegin()[max_size - (start[b + 1] - start[b]) + 1];
+            }
+            for (size_t s = 0; s <= max_size; ++s) {
+                size_start.GetBegin()[s + 1] += size_start.GetBegin()[s];
+            }
+            for (size_t b = 0; b < buckets; ++b) {
+                by_size.GetBegin()[size_start.GetBegin()[max_size - (start[b + 1] - start[b])]++] =
+                    static_cast<uint32_t>(b);
+            }
+        }
+
+        data.pilots = DynamicArray<uint16_t>(buckets);
+        DynamicArray<uint32_t> slot_of(count);
+        DynamicArray<uint8_t> taken(data.slots);
+        std::memset(taken.GetBegin(), 0, data.slots);
+        DynamicArray<size_t> trial(max_size == 0 ? 1 : max_size);
+        for (size_t k = 0; k < buckets; ++k) {
+            size_t b = by_size.GetBegin()[k];
+            const uint32_t* first = members.GetBegin() + start[b];
+            const size_t size = start[b + 1] - start[b];
+            if (size == 0) {
+                data.pilots.GetBegin()[b] = 0;
+                continue;
+            }
+            for (size_t i = 0; i < size; ++i) {
+                for (size_t j = 0; j < i; ++j) {
+                    if (hashes.GetBegin()[first[i]] == hashes.GetBegin()[first[j]]) {
+                        return false;
+                    }
+                }
+            }
+            bool placed = false;
+            for (size_t pilot = 0; pilot <= kMaxPilot && !placed; ++pilot) {
+                placed = true;
+                for (size_t i = 0; i < size && placed; ++i) {
+                    size_t slot = Slot(hashes.GetBegin()[first[i]], pilot, data.slots);
+                    placed = taken.GetBegin()[slot] == 0;
+                    for (size_t j = 0; j < i && placed; ++j) {
+                        placed = trial.GetBegin()[j] != slot;
+                    }
+                    trial.GetBegin()[i] = slot;
+                }
+                if (placed) {
+                    data.pilots.GetBegin()[b] = static_cast<uint16_t>(pilot);
+                    for (size_t i = 0; i < size; ++i) {
+                        taken.GetBegin()[trial.GetBegin()[i]] = 1;
+                        slot_of.GetBegin()[first[i]] = static_cast<uint32_t>(trial.GetBegin()[i]);
+                    }
+                }
+            }
+            if (!placed) {
+                return false;
+            }
+        }
+
+        // Slots past the end move into the free slots below it, in order.
+        data.remap = DynamicArray<uint32_t>(data.slots - count);
+        size_t hole = 0;
+        for (size_t slot = count; slot < data.slots; ++slot) {
+            if (taken.GetBegin()[slot] != 0) {
+                while (taken.GetBegin()[hole] != 0) {
+                    ++hole;
+                }
+                data.remap.GetBegin()[slot - count] = static_cast<uint32_t>(hole++);
+            } else {
+                data.remap.GetBegin()[slot - count] = 0;
+            }
+        }
+
+        DynamicArray<uint32_t> key_of(count);
+        size_t key_bytes = 0;
+        for (size_t i = 0; i < count; ++i) {
+            size_t slot = slot_of.GetBegin()[i];
+            size_t pos = slot < count ? slot : data.remap.GetBegin()[slot - count];
+            key_of.GetBegin()[pos] = static_cast<uint32_t>(i);
+            key_bytes += entries.Get(i).key.size();
+        }
+        if (key_bytes > UINT32_MAX) {
+            throw std::length_error("PerfectHashTable: keys exceed 4 GiB");
+        }
+        data.offsets = DynamicArray<uint32_t>(count + 1);
+        data.keys = DynamicArray<char>(key_bytes);
+        data.values = DynamicArray<Value>(count);
+        uint32_t offset = 0;
+        for (size_t pos = 0; pos < count; ++pos) {
+            const Pair& entry = entries.Get(key_of.GetBegin()[pos]);
+            data.offsets.GetBegin()[pos] = offset;
+            std::memcpy(data.keys.GetBegin() + offset, entry.key.data(), entry.key.size());
+            offset += static_cast<uint32_t>(entry.key.size());
+            data.values.GetBegin()[pos] = entry.value;
+        }
+        data.offsets.GetBegin()[count] = offset;
+        return true;
+    }
+
+    template <typename T>
+    static void WriteArray(std::ostream& out, const DynamicArray<T>& array) {
+        out.write(reinterpret_cast<const char*>(array.GetBegin()), array.GetSize() * sizeof(T));
+    }
+
+    template <typename T>
+    static bool ReadArray(std::istream& in, DynamicArray<T>& array, uint64_t size) {
+        // Refuse sizes that could not have come from a real table before
+        // allocating for them.
+        if (size > (uint64_t{1} << 40) / sizeof(T)) {
+            return false;
+        }
+        array = DynamicArray<T>(size);
+        return size == 0 || static_cast<bool>(in.read(reinterpret_cast<char*>(array.GetBegin()), size * sizeof(T)));
+    }
+
+    std::shared_ptr<const Storage> data_;
+#ifdef LAB2_STATS
+    mutable LookupStats stats_;
+#endif
+};
+
+// Freezes a finished index into a PerfectHashTable for the read path.
+template <typename Value>
+std::shared_ptr<PerfectHashTable<Value>> Freeze(const IDictionary<std::string, Value>& source) {
+    return std::make_shared<PerfectHashTable<Value>>(source);
+}
@@ -0,0 +1,428 @@
+#pragma once
+
+#include <concepts>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+#include "fwd.hpp"
+#include "array_sequence.hpp"
+#include "memory.hpp"
+#include "sequence.hpp"
+#include "small_sequence.hpp"
+#include "stats.hpp"
+#include "stream.hpp"
+#include "utf8.hpp"
+
+// Text pipeline: StringCharStream -> LexerStream -> LineRenderer ->
+// PaginatorStream. Every stage is a template over the concrete type of its
+// source and, where it matters, over a mode policy. The LexerStream /
+// LineRenderer / PaginatorStream aliases read from the abstract Stream<T> and
+// take the mode at run time, for dynamic composition; Paginate instead
+// instantiates the whole chain on concrete types with the mode fixed, so the
+// reads are direct calls and the per-word mode checks fold away.
+
+enum class AlphabetIndexMode { Words, Chars };
+
+// Mode chosen at run time.
+class RuntimeMode {
+public:
+    explicit RuntimeMode(AlphabetIndexMode mode) : mode_(mode) {
+    }
+
+    AlphabetIndexMode Get() const {
+        return mode_;
+    }
+
+private:
+    AlphabetIndexMode mode_;
+};
+
+// Mode fixed at compile time; the constructor argument is ignored.
+template <AlphabetIndexMode M>
+class StaticMode {
+public:
+    explicit StaticMode(AlphabetIndexMode) {
+    }
+
+    static constexpr AlphabetIndexMode Get() {
+        return M;
+    }
+};
+
+struct Line {
+    // Lines hold a single word in Words mode, so a couple of words are kept
+    // inline in the sequence object.
+    static constexpr size_t kInlineWords = 2;
+
+    SequencePtr<std::string> words;
+};
+
+struct Page {
+    int number = 0;
+    SequencePtr<Line> lines;
+};
+
+class StringCharStream final : public Stream<char> {
+public:
+    explicit StringCharStream(std::string t) : text_(std::move(t)) {
+    }
+
+    bool Read(char& out) override {
+        if (pos_ >= text_.size())
+            return false;
+        out = text_[pos_++];
+        return true;
+    }
+
+    bool IsEnd() const override {
+        return pos_ >= text_.size();
+    }
+
+    bool Seek(size_t p) override {
+        if (p > text_.size())
+            return false;
+        pos_ = p;
+        return true;
+    }
+
+    // Unread part of the text, for stages that scan it in place.
+    std::string_view Remaining() const {
+        return std::string_view(text_).substr(pos_);
+    }
+
+    void Advance(size_t n) {
+        pos_ += n;
+    }
+
+private:
+    std::string text_;
+    size_t pos_ = 0;
+};
+
+// A source that exposes its unread characters as one buffer.
+template <typename Source>
+concept ContiguousCharSource = requires(Source& source, size_t n) {
+    { source.Remaining() } -> std::convertible_to<std::string_view>;
+    source.Advance(n);
+};
+
+// Splits UTF-8 text into words separated by Unicode whitespace. A contiguous
+// source is scanned in place (see FindSpace), anything else is decoded one
+// character at a time. Malformed bytes are kept in the words as they are.
+template <typename Source>
+class BasicLexerStream final : public Stream<std::string> {
+public:
+    explicit BasicLexerStream(Source& source) : source_(source) {
+    }
+
+    bool Read(std::string& out) override {
+        LAB2_STAT(StatTimer timer(stats_.ns));
+        out.clear();
+        bool found;
+        if constexpr (ContiguousCharSource<Source>) {
+            found = ReadInPlace(out);
+        } else {
+            found = ReadByCharacter(out);
+        }
+        if (!found) {
+            return false;
+        }
+        LAB2_STAT(++stats_.items);
+        LAB2_STAT(stats_.bytes += out.size());
+        return true;
+    }
+
+    bool IsEnd() const override {
+        return !has_pushback_ && source_.IsEnd();
+    }
+
+    bool Seek(size_t pos) override {
+        has_pushback_ = false;
+        return source_.Seek(pos);
+    }
+
+    StageStats GetStats() const {
+#ifdef LAB2_STATS
+        return stats_;
+#else
+        return StageStats{};
+#endif
+    }
+
+private:
+    bool ReadInPlace(std::string& out) {
+        std::string_view text = source_.Remaining();
+        size_t begin = SkipSpace(text, 0);
+        if (begin == text.size()) {
+            source_.Advance(text.size());
+            return false;
+        }
+        size_t end = FindSpace(text, begin);
+        out.assign(text.data() + begin, end - begin);
+        source_.Advance(end);
+        return true;
+    }
+
+    bool ReadByCharacter(std::string& out) {
+        char buf[4];
+        size_t length;
+        bool space;
+        do {
+            if (!ReadCharacter(buf, length, space)) {
+                return false;
+            }
+        } while (space);
+        do {
+            out.append(buf, length);
+        } while (ReadCharacter(buf, length, space) && !space);
+        return true;
+    }
+
+    // Reads the bytes of one character into `buf`. A byte that cannot
+    // continue the sequence is pushed back and read as the next character.
+    bool ReadCharacter(char* buf, size_t& length, bool& space) {
+        if (!ReadByte(buf[0])) {
+            return false;
+        }
+        auto lead = static_cast<unsigned char>(buf[0]);
+        if (lead < 0x80) {
+            length = 1;
+            space = IsAsciiSpace(lead);
+            return true;
+        }
+        size_t need = Utf8SequenceLength(lead);
+        length = 1;
+        while (length < need) {
+            char ch;
+            if (!ReadByte(ch)) {
+                break;
+            }
+            if ((static_cast<unsigned char>(ch) & 0xC0) != 0x80) {
+                pushback_ = ch;
+                has_pushback_ = true;
+                break;
+            }
+            buf[length++] = ch;
+        }
+        char32_t cp;
+        space = DecodeUtf8(buf, length, cp) == length && IsSpace(cp);
+        return true;
+    }
+
+    bool ReadByte(char& ch) {
+        if (has_pushback_) {
+            ch = pushback_;
+            has_pushback_ = false;
+            return true;
+        }
+        return source_.Read(ch);
+    }
+
+    Source& source_;
+    bool has_pushback_ = false;
+    char pushback_ = 0;
+#ifdef LAB2_STATS
+    StageStats stats_;
+#endif
+};
+
+template <typename Source, typename Mode = RuntimeMode>
+class BasicLineRenderer final : public Stream<Line> {
+public:
+    BasicLineRenderer(Source& source, size_t line_limit, AlphabetIndexMode mode,
+                      std::pmr::memory_resource* resource = DefaultResource())
+        : source_(source), line_limit_(line_limit == 0 ? 1 : line_limit), mode_(mode), resource_(resource) {
+    }
+
+    bool Read(Line& out) override {
+        LAB2_STAT(StatTimer timer(stats_.ns));
+        auto words = MakeShared<SmallSequence<std::string, Line::kInlineWords>>(resource_, resource_);
+        size_t used = 0;
+
+        auto add_word = [&](const std::string& w) -> bool {
+            size_t wsize = WordWeight(w, used);
+            if (used > 0 && used + wsize > line_limit_) {
+                pending_ = w;
+                has_pending_ = true;
+                return false;
+            }
+            used += wsize;
+            words->Append(w);
+            LAB2_STAT(stats_.bytes += w.size());
+            return true;
+        };
+
+        std::string token;
+        if (has_pending_) {
+            token = std::move(pending_);
+            has_pending_ = false;
+        } else if (!source_.Read(token)) {
+            return false;
+        }
+
+        while (true) {
+            if (!add_word(token)) {
+                break;
+            }
+            if (!source_.Read(token)) {
+                break;
+            }
+        }
+
+        if (words->GetLength() == 0) {
+            return false;
+        }
+
+        out.words = words;
+        LAB2_STAT(++stats_.items);
+        return true;
+    }
+
+    bool IsEnd() const override {
+        return !has_pending_ && source_.IsEnd();
+    }
+
+    StageStats GetStats() const {
+#ifdef LAB2_STATS
+        return stats_;
+#else
+        return StageStats{};
+#endif
+    }
+
+private:
+    size_t WordWeight(const std::string& word, size_t current) const {
+        if (mode_.Get() == AlphabetIndexMode::Words)
+            return 1;
+        return word.size() + (current == 0 ? 0 : 1);
+    }
+
+    Source& source_;
+    size_t line_limit_;
+    Mode mode_;
+    std::pmr::memory_resource* resource_;
+    bool has_pending_ = false;
+    std::string pending_;
+#ifdef LAB2_STATS
+    StageStats stats_;
+#endif
+};
+
+template <typename Source, typename Mode = RuntimeMode>
+class BasicPaginatorStream final : public Stream<Page> {
+public:
+    BasicPaginatorStream(Source& source, size_t page_size, AlphabetIndexMode mode,
+                         std::pmr::memory_resource* resource = DefaultResource())
+        : source_(source), page_size_(page_size), mode_(mode), resource_(resource) {
+    }
+
+    bool Read(Page& out) override {
+        LAB2_STAT(StatTimer timer(stats_.ns));
+        auto lines = MakeShared<ArraySequence<Line>>(resource_, resource_);
+        size_t cap = PageCapacity(current_page_);
+        size_t used = 0;
+
+        auto take_line = [&](const Line& line) -> bool {
+            size_t w = LineWeight(line);
+            if (used == 0 && w > cap) {
+                used += w;
+                lines->Append(line);
+                return true;
+            }
+            if (used + w > cap) {
+                pending_ = line;
+                has_pending_ = true;
+                return false;
+            }
+            used += w;
+            lines->Append(line);
+            return true;
+        };
+
+        if (has_pending_) {
+            if (!take_line(pending_)) {
+                return false;
+            }
+            has_pending_ = false;
+        }
+
+        Line line;
+        while (source_.Read(line)) {
+            if (!take_line(line)) {
+                break;
+            }
+        }
+
+        if (lines->GetLength() == 0) {
+            return false;
+        }
+
+        out.number = current_page_;
+        out.lines = lines;
+        ++current_page_;
+#ifdef LAB2_STATS
+        ++stats_.items;
+        for (auto lit = lines->GetIterator(); lit->HasNext(); lit->Next()) {
+            for (auto wit = lit->GetCurrentItem().words->GetIterator(); wit->HasNext(); wit->Next()) {
+                stats_.bytes += wit->GetCurrentItem().size();
+            }
+        }
+#endif
+        return true;
+    }
+
+    bool IsEnd() const override {
+        return !has_pending_ && source_.IsEnd();
+    }
+
+    StageStats GetStats() const {
+#ifdef LAB2_STATS
+        return stats_;
+#else
+        return StageStats{};
+#endif
+    }
+
+private:
+    size_t PageCapacity(size_t page) const {
+        size_t cap = page_size_;
+        if (page == 1) {
+            cap = page_size_ / 2;
+        } else if (page % 10 == 0) {
+            cap = (page_size_ * 3) / 4;
+        }
+        return cap == 0 ? 1 : cap;
+    }
+
+    size_t LineWeight(const Line& line) const {
+        if (mode_.Get() == AlphabetIndexMode::Words) {
+            return line.words->GetLength();
+        }
+        size_t total = 0;
+        bool first = true;
+        for (auto wit = line.words->GetIterator(); wit->HasNext(); wit->Next()) {
+            total += wit->GetCurrentItem().size();
+            if (!first) {
+                ++total;
+            }
+            first = false;
+        }
+        return total;
+    }
+
+    Source& source_;
+    size_t page_size_;
+    Mode mode_;
+    std::pmr::memory_resource* resource_;
+    size_t current_page_ = 1;
+    bool has_pending_ = false;
+    Line pending_;
+#ifdef LAB2_STATS
+    StageStats stats_;
+#endif
+};
+
+using LexerStream = BasicLexerStream<Stream<char>>;
+using LineRenderer = BasicLineRenderer<Stream<std::string>>;
+using PaginatorStream = BasicPaginatorStream<Stream<Line>>;
@@ -0,0 +1,313 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include "array_sequence.hpp"
+#include "iiterator.hpp"
+
+struct Posting {
+    int page = 0;
+    int line = 0;
+
+    bool operator==(const Posting& other) const = default;
+};
+
+// Sorted list of (page, line) occurrences stored as delta + varint encoded
+// blocks. Every kBlockSize postings a skip entry is recorded so that cursors
+// can jump over whole blocks during intersection.
+class PostingList {
+    static constexpr size_t kBlockSize = 64;
+
+    struct SkipEntry {
+        int base_page = 0;
+        int first_page = 0;
+        size_t offset = 0;
+    };
+
+public:
+    explicit PostingList(bool with_lines = false) : with_lines_(with_lines) {
+    }
+
+    // Postings must be added in non-decreasing (page, line) order. Repeated
+    // occurrences on the same page (or line, when lines are tracked) are
+    // collapsed into one posting.
+    void Add(int page, int line = 0) {
+        if (count_ > 0) {
+            if (page < last_page_ || (page == last_page_ && with_lines_ && line < last_line_)) {
+                throw std::invalid_argument("Postings must be added in sorted order");
+            }
+            if (page == last_page_ && (!with_lines_ || line == last_line_)) {
+                return;
+            }
+        }
+        if (count_ % kBlockSize == 0) {
+            skips_.Append(SkipEntry{last_page_, page, bytes_.GetLength()});
+        }
+        WriteVarint(static_cast<uint32_t>(page - last_page_));
+        if (with_lines_) {
+            WriteVarint(static_cast<uint32_t>(line));
+        }
+        if (count_ == 0 || page != last_page_) {
+            ++page_count_;
+        }
+        last_page_ = page;
+        last_line_ = line;
+        ++count_;
+    }
+
+    size_t GetCount() const {
+        return count_;
+    }
+
+    size_t GetPageCount() const {
+        return page_count_;
+    }
+
+    size_t GetByteSize() const {
+        return bytes_.GetLength();
+    }
+
+    bool GetWithLines() const {
+        return with_lines_;
+    }
+
+    int GetFirstPage() const {
+        if (count_ == 0) {
+            throw std::out_of_range("Posting list is empty");
+        }
+        return skips_.GetFirst().first_page;
+    }
+
+    int GetLastPage() const {
+        if (count_ == 0) {
+            throw std::out_of_range("Posting list is empty");
+        }
+        return last_page_;
+    }
+
+    IIteratorPtr<Posting> GetIterator() const;
+
+private:
+    friend class PostingCursor;
+
+    void WriteVarint(uint32_t value) {
+        while (value >= 0x80) {
+            bytes_.Append(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes_.Append(static_cast<uint8_t>(value));
+    }
+
+    bool with_lines_;
+    size_t count_ = 0;
+    size_t page_count_ = 0;
+    int last_page_ = 0;
+    int last_line_ = 0;
+    ArraySequence<uint8_t> bytes_;
+    ArraySequence<SkipEntry> skips_;
+};
+
+using PostingListPtr = std::shared_ptr<PostingList>;
+
+// Forward-only decoder over a PostingList. SkipTo uses the skip entries to
+// avoid decoding blocks that lie entirely before the target page.
+class PostingCursor {
+public:
+    explicit PostingCursor(const PostingList& list) : list_(list) {
+        if (list_.count_ > 0) {
+            Decode();
+        }
+    }
+
+    bool IsValid() const {
+        return index_ < list_.count_;
+    }
+
+    const Posting& GetCurrent() const {
+        if (!IsValid()) {
+            throw std::out_of_range("No next element");
+        }
+        return current_;
+    }
+
+    void Next() {
+        if (!IsValid()) {
+            return;
+        }
+        ++index_;
+        if (IsValid()) {
+            Decode();
+        }
+    }
+
+    // Moves to the first posting whose page is not less than `page`.
+    void SkipTo(int page) {
+        if (!IsValid() || current_.page >= page) {
+            return;
+        }
+        // Last block that starts before `page`: in lines mode a page can
+        // span blocks, and its first postings may sit in that block's tail.
+        size_t block = index_ / PostingList::kBlockSize;
+        size_t l = block;
+        size_t r = list_.skips_.GetLength();
+        while (l + 1 < r) {
+            size_t mid = (l + r) / 2;
+            if (list_.skips_[mid].first_page < page) {
+                l = mid;
+            } else {
+                r = mid;
+            }
+        }
+        if (l > block) {
+            const auto& skip = list_.skips_[l];
+            index_ = l * PostingList::kBlockSize;
+            offset_ = skip.offset;
+            current_.page = skip.base_page;
+            Decode();
+        }
+        while (IsValid() && current_.page < page) {
+            Next();
+        }
+    }
+
+    // Moves past every remaining posting on the current page.
+    void NextPage() {
+        int page = current_.page;
+        while (IsValid() && current_.page == page) {
+            Next();
+        }
+    }
+
+private:
+    uint32_t ReadVarint() {
+        uint32_t value = 0;
+        int shift = 0;
+        while (true) {
+            uint8_t byte = list_.bytes_[offset_++];
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+            shift += 7;
+        }
+    }
+
+    void Decode() {
+        current_.page += static_cast<int>(ReadVarint());
+        current_.line = list_.with_lines_ ? static_cast<int>(ReadVarint()) : 0;
+    }
+
+    const PostingList& list_;
+    size_t index_ = 0;
+    size_t offset_ = 0;
+    Posting current_;
+};
+
+class PostingIterator : public IIterator<Posting> {
+public:
+    explicit PostingIterator(const PostingList& list) : cursor_(list) {
+    }
+
+    bool HasNext() const override {
+        return cursor_.IsValid();
+    }
+
+    bool Next() override {
+        if (!HasNext()) {
+            return false;
+        }
+        cursor_.Next();
+        return true;
+    }
+
+    const Posting& GetCurrentItem() const override {
+        return cursor_.GetCurrent();
+    }
+
+    bool TryGetCurrentItem(Posting& element) const override {
+        if (!HasNext()) {
+            return false;
+        }
+        element = cursor_.GetCurrent();
+        return true;
+    }
+
+private:
+    PostingCursor cursor_;
+};
+
+inline IIteratorPtr<Posting> PostingList::GetIterator() const {
+    return std::make_shared<PostingIterator>(*this);
+}
+
+// Pages present in every list, in increasing order. The shortest list drives
+// the intersection and the others leapfrog to each candidate via SkipTo.
+inline SequencePtr<int> IntersectPages(const Sequence<PostingListPtr>& lists) {
+    auto res = std::make_shared<ArraySequence<int>>();
+    size_t n = lists.GetLength();
+    if (n == 0) {
+        return res;
+    }
+    size_t driver = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (lists.Get(i) == nullptr || lists.Get(i)->GetCount() == 0) {
+            return res;
+        }
+        if (lists.Get(i)->GetPageCount() < lists.Get(driver)->GetPageCount()) {
+            driver = i;
+        }
+    }
+    DynamicArray<std::shared_ptr<PostingCursor>> cursors(n);
+    for (size_t i = 0; i < n; ++i) {
+        cursors.Set(std::make_shared<PostingCursor>(*lists.Get(i)), i);
+    }
+    PostingCursor& lead = *cursors.Get(driver);
+    while (lead.IsValid()) {
+        int page = lead.GetCurrent().page;
+        bool all = true;
+        for (size_t i = 0; i < n && all; ++i) {
+            if (i == driver) {
+                continue;
+            }
+            PostingCursor& other = *cursors.Get(i);
+            other.SkipTo(page);
+            if (!other.IsValid()) {
+                return res;
+            }
+            if (other.GetCurrent().page != page) {
+                lead.SkipTo(other.GetCurrent().page);
+                all = false;
+            }
+        }
+        if (all) {
+            res->Append(page);
+            lead.NextPage();
+        }
+    }
+    return res;
+}
+
+// Formats "page, page, ..." (or "page:line, ...") into any writer with
+// stream-like operator<<.
+template <typename Out>
+Out& FormatPostings(Out& out, const PostingList& list) {
+    bool first = true;
+    for (PostingCursor cur(list); cur.IsValid(); cur.Next()) {
+        if (!first) {
+            out << ", ";
+        }
+        out << cur.GetCurrent().page;
+        if (list.GetWithLines()) {
+            out << ':' << cur.GetCurrent().line;
+        }
+        first = false;
+    }
+    return out;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const PostingList& list) {
+    return FormatPostings(os, list);
+}
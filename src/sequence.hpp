@@ -25,6 +25,11 @@ public:
         return GetLength();
     }
 
+    // Makes room for `capacity` elements up front; a no-op for sequences
+    // without a contiguous buffer.
+    virtual void Reserve(size_t) {
+    }
+
     virtual void Append(const T& item) = 0;
     virtual void Prepend(const T& item) = 0;
     virtual void InsertAt(const T& item, size_t index) = 0;
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "array_sequence.hpp"
+#include "bounds_check.hpp"
+#include "idictionary.hpp"
+#include "sequence.hpp"
+
+// Read-only sequences over storage owned by someone else, returned by
+// dictionaries from GetKeys/GetValues instead of a copy. A view shares
+// ownership of what it reads; Materialize() makes an owned copy. Mutators
+// throw std::logic_error.
+template <typename T>
+class SequenceView : public Sequence<T> {
+public:
+    const T& GetFirst() const override {
+        if (this->GetLength() == 0) {
+            throw std::out_of_range("Sequence is empty");
+        }
+        return this->Get(0);
+    }
+
+    const T& GetLast() const override {
+        if (this->GetLength() == 0) {
+            throw std::out_of_range("Sequence is empty");
+        }
+        return this->Get(this->GetLength() - 1);
+    }
+
+    // Sub-ranges are copied, like ArraySequence's.
+    SequencePtr<T> GetSubsequence(size_t startIndex, size_t endIndex) const override {
+        size_t size = this->GetLength();
+        if (startIndex >= size || endIndex >= size) {
+            throw std::out_of_range("Index is out of range: " + std::to_string(startIndex) + " " +
+                                    std::to_string(endIndex) + " " + std::to_string(size));
+        }
+        if (startIndex > endIndex) {
+            throw std::out_of_range("startIndex is greater than endIndex");
+        }
+        return Copy(startIndex, endIndex + 1);
+    }
+
+    SequencePtr<T> GetFirst(size_t count) const override {
+        if (count > this->GetLength()) {
+            throw std::out_of_range("Requested elements count is greater than size");
+        }
+        return Copy(0, count);
+    }
+
+    SequencePtr<T> GetLast(size_t count) const override {
+        if (count > this->GetLength()) {
+            throw std::out_of_range("Requested elements count is greater than size");
+        }
+        return Copy(this->GetLength() - count, this->GetLength());
+    }
+
+    void Set(const T&, size_t) override {
+        ReadOnly();
+    }
+
+    void Append(const T&) override {
+        ReadOnly();
+    }
+
+    void Prepend(const T&) override {
+        ReadOnly();
+    }
+
+    void InsertAt(const T&, size_t) override {
+        ReadOnly();
+    }
+
+    void EraseAt(size_t) override {
+        ReadOnly();
+    }
+
+    void Clear() override {
+        ReadOnly();
+    }
+
+    // An owned copy of the elements.
+    SequencePtr<T> Materialize() const {
+        return Copy(0, this->GetLength());
+    }
+
+private:
+    [[noreturn]] static void ReadOnly() {
+        throw std::logic_error("Sequence view is read-only");
+    }
+
+    SequencePtr<T> Copy(size_t begin, size_t end) const {
+        auto res = std::make_shared<ArraySequence<T>>();
+        res->Reserve(end - begin);
+        auto it = this->GetIterator();
+        for (size_t i = 0; i < begin; ++i) {
+            it->Next();
+        }
+        for (size_t i = begin; i < end; ++i, it->Next()) {
+            res->Append(it->GetCurrentItem());
+        }
+        return res;
+    }
+};
+
+// An owned sequence: `sequence` itself unless it is a view.
+template <typename T>
+SequencePtr<T> Materialize(const SequencePtr<T>& sequence) {
+    if (auto view = std::dynamic_pointer_cast<SequenceView<T>>(sequence)) {
+        return view->Materialize();
+    }
+    return sequence;
+}
+
+// Shared ownership of `source` when it is held by a shared_ptr; otherwise a
+// non-owning pointer, and `source` must outlive whatever holds it.
+template <typename Source>
+std::shared_ptr<const Source> ShareOrBorrow(const Source& source) {
+    if (auto owner = source.weak_from_this().lock()) {
+        return owner;
+    }
+    return std::shared_ptr<const Source>(std::shared_ptr<const Source>(), &source);
+}
+
+// Array iterator that keeps the array's owner alive, so it stays valid
+// after the view that made it is gone.
+template <typename T>
+class OwningArrayIterator : public ArraySequenceIterator<T> {
+public:
+    OwningArrayIterator(const T* data, size_t size, std::shared_ptr<const void> owner)
+        : ArraySequenceIterator<T>(data, size), owner_(std::move(owner)) {
+    }
+
+private:
+    std::shared_ptr<const void> owner_;
+};
+
+// View of a contiguous array kept alive by `owner`.
+template <typename T>
+class ArrayView : public SequenceView<T> {
+public:
+    ArrayView(const T* data, size_t size, std::shared_ptr<const void> owner)
+        : data_(data), size_(size), owner_(std::move(owner)) {
+    }
+
+    const T& Get(size_t index) const override {
+        CheckIndex(index, size_);
+        return data_[index];
+    }
+
+    size_t GetLength() const override {
+        return size_;
+    }
+
+    IIteratorPtr<T> GetIterator() const override {
+        return std::make_shared<OwningArrayIterator<T>>(data_, size_, owner_);
+    }
+
+private:
+    const T* data_;
+    size_t size_;
+    std::shared_ptr<const void> owner_;
+};
+
+// View of a snapshot of `items`. The snapshot shares the buffer, so taking
+// it is O(1); the next write to `items` copies the elements out instead, and
+// the view stays valid and unchanged.
+template <typename T>
+SequencePtr<T> ShareArray(const ArraySequence<T>& items) {
+    auto snapshot = std::make_shared<const ArraySequence<T>>(items);
+    return std::make_shared<ArrayView<T>>(snapshot->GetBegin(), snapshot->GetLength(), snapshot);
+}
+
+// Projects one field of the entries of a dictionary iterator.
+template <typename Key, typename Value, typename T, T KeyValue<Key, Value>::*Field>
+class EntryFieldIterator : public IIterator<T> {
+public:
+    explicit EntryFieldIterator(IIteratorPtr<KeyValue<Key, Value>> entries) : entries_(std::move(entries)) {
+    }
+
+    bool HasNext() const override {
+        return entries_->HasNext();
+    }
+
+    bool Next() override {
+        return entries_->Next();
+    }
+
+    const T& GetCurrentItem() const override {
+        return entries_->GetCurrentItem().*Field;
+    }
+
+    bool TryGetCurrentItem(T& element) const override {
+        if (!HasNext()) {
+            return false;
+        }
+        element = GetCurrentItem();
+        return true;
+    }
+
+private:
+    IIteratorPtr<KeyValue<Key, Value>> entries_;
+};
+
+// View of the keys or values of a dictionary, in its iteration order. Get
+// walks the dictionary's iterator and keeps its position, so reading the
+// elements in order costs one step each; going back restarts the walk. The
+// cursor makes concurrent Get calls on one view unsafe. Get returns what the
+// iterator points at, so the view only suits dictionaries whose iterators
+// return references into their storage; CopyKeys/CopyValues serve the rest.
+template <typename Key, typename Value, typename T, T KeyValue<Key, Value>::*Field>
+class EntryFieldView : public SequenceView<T> {
+public:
+    explicit EntryFieldView(std::shared_ptr<const IDictionary<Key, Value>> source) : source_(std::move(source)) {
+    }
+
+    const T& Get(size_t index) const override {
+        CheckIndex(index, GetLength());
+        if (cursor_ == nullptr || index < position_) {
+            cursor_ = source_->GetIterator();
+            position_ = 0;
+        }
+        for (; position_ < index; ++position_) {
+            cursor_->Next();
+        }
+        return cursor_->GetCurrentItem().*Field;
+    }
+
+    size_t GetLength() const override {
+        return source_->GetCount();
+    }
+
+    IIteratorPtr<T> GetIterator() const override {
+        return std::make_shared<EntryFieldIterator<Key, Value, T, Field>>(source_->GetIterator());
+    }
+
+private:
+    std::shared_ptr<const IDictionary<Key, Value>> source_;
+    mutable IIteratorPtr<KeyValue<Key, Value>> cursor_;
+    mutable size_t position_ = 0;
+};
+
+template <typename Key, typename Value>
+using KeysView = EntryFieldView<Key, Value, Key, &KeyValue<Key, Value>::key>;
+
+template <typename Key, typename Value>
+using ValuesView = EntryFieldView<Key, Value, Value, &KeyValue<Key, Value>::value>;
+
+// Owned copy of the keys or values, for dictionaries whose iterators build
+// each entry as they go and so leave nothing stable for a view to return.
+template <typename Key, typename Value, typename T, T KeyValue<Key, Value>::*Field>
+SequencePtr<T> CopyEntryField(const IDictionary<Key, Value>& source) {
+    auto res = std::make_shared<ArraySequence<T>>();
+    res->Reserve(source.GetCount());
+    for (auto it = source.GetIterator(); it->HasNext(); it->Next()) {
+        res->Append(it->GetCurrentItem().*Field);
+    }
+    return res;
+}
+
+template <typename Key, typename Value>
+SequencePtr<Key> CopyKeys(const IDictionary<Key, Value>& source) {
+    return CopyEntryField<Key, Value, Key, &KeyValue<Key, Value>::key>(source);
+}
+
+template <typename Key, typename Value>
+SequencePtr<Value> CopyValues(const IDictionary<Key, Value>& source) {
+    return CopyEntryField<Key, Value, Value, &KeyValue<Key, Value>::value>(source);
+}
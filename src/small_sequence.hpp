@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "array_sequence.hpp"
+#include "bounds_check.hpp"
+#include "dynamic_array.hpp"
+#include "sequence.hpp"
+
+// Array-backed sequence that keeps up to N elements inline and spills to a
+// heap buffer only when it grows beyond that. Short sequences therefore cost
+// no allocation beyond the sequence object itself.
+template <typename T, size_t N>
+class SmallSequence : public Sequence<T> {
+    static_assert(N > 0, "Inline capacity must be positive");
+
+public:
+    SmallSequence() {
+    }
+
+    explicit SmallSequence(std::pmr::memory_resource* resource) : resource_(resource) {
+    }
+
+    SmallSequence(const T* items, size_t count) {
+        Grow(count);
+        std::copy(items, items + count, data_);
+        size_ = count;
+    }
+
+    SmallSequence(const Sequence<T>& a) {
+        for (IIteratorPtr<T> it = a.GetIterator(); it->HasNext(); it->Next()) {
+            Append(it->GetCurrentItem());
+        }
+    }
+
+    SmallSequence(const SmallSequence<T, N>& v) : SmallSequence(v.data_, v.size_) {
+    }
+
+    SmallSequence(SmallSequence<T, N>&& v) {
+        MoveFrom(std::move(v));
+    }
+
+    SmallSequence<T, N>& operator=(const SmallSequence<T, N>& v) {
+        if (this != &v) {
+            Clear();
+            Grow(v.size_);
+            std::copy(v.data_, v.data_ + v.size_, data_);
+            size_ = v.size_;
+        }
+        return *this;
+    }
+
+    SmallSequence<T, N>& operator=(SmallSequence<T, N>&& v) {
+        if (this != &v) {
+            Clear();
+            MoveFrom(std::move(v));
+        }
+        return *this;
+    }
+
+    const T& GetFirst() const override {
+        if (size_ == 0) {
+            throw std::out_of_range("Sequence is empty");
+        }
+        return data_[0];
+    }
+
+    const T& GetLast() const override {
+        if (size_ == 0) {
+            throw std::out_of_range("Sequence is empty");
+        }
+        return data_[size_ - 1];
+    }
+
+    const T& Get(size_t index) const override {
+        CheckIndex(index, size_);
+        return data_[index];
+    }
+
+    // Unchecked access for indices that are valid by construction.
+    const T& operator[](size_t index) const {
+        CheckIndexIfEnabled(index, size_);
+        return data_[index];
+    }
+
+    void Set(const T& item, size_t index) override {
+        CheckIndex(index, size_);
+        data_[index] = item;
+    }
+
+    SequencePtr<T> GetSubsequence(size_t startIndex, size_t endIndex) const override {
+        if (startIndex >= size_ || endIndex >= size_) {
+            throw std::out_of_range("Index is out of range: " + std::to_string(startIndex) + " " +
+                                    std::to_string(endIndex) + " " + std::to_string(size_));
+        }
+        if (startIndex > endIndex) {
+            throw std::out_of_range("startIndex is greater than endIndex");
+        }
+        return std::make_shared<SmallSequence<T, N>>(data_ + startIndex, endIndex - startIndex + 1);
+    }
+
+    SequencePtr<T> GetFirst(size_t count) const override {
+        if (count == 0) {
+            return std::make_shared<SmallSequence<T, N>>();
+        }
+        if (count > size_) {
+            throw std::out_of_range("Requested elements count is greater than size");
+        }
+        return GetSubsequence(0, count - 1);
+    }
+
+    SequencePtr<T> GetLast(size_t count) const override {
+        if (count == 0) {
+            return std::make_shared<SmallSequence<T, N>>();
+        }
+        if (count > size_) {
+            throw std::out_of_range("Requested elements count is greater than size");
+        }
+        return GetSubsequence(size_ - count, size_ - 1);
+    }
+
+    size_t GetLength() const override {
+        return size_;
+    }
+
+    size_t GetCapacity() const override {
+        return capacity_;
+    }
+
+    bool IsInline() const {
+        return data_ == inline_;
+    }
+
+    void Reserve(size_t capacity) override {
+        Grow(capacity);
+    }
+
+    void Append(const T& item) override {
+        if (size_ == capacity_) {
+            Grow(capacity_ * 2);
+        }
+        data_[size_++] = item;
+    }
+
+    void Prepend(const T& item) override {
+        InsertAt(item, 0);
+    }
+
+    void InsertAt(const T& item, size_t index) override {
+        if (index > size_) {
+            ThrowIndexOutOfRange(index, size_);
+        }
+        if (size_ == capacity_) {
+            Grow(capacity_ * 2);
+        }
+        std::move_backward(data_ + index, data_ + size_, data_ + size_ + 1);
+        data_[index] = item;
+        ++size_;
+    }
+
+    void EraseAt(size_t index) override {
+        CheckIndex(index, size_);
+        std::move(data_ + index + 1, data_ + size_, data_ + index);
+        data_[--size_] = T();
+    }
+
+    void Clear() override {
+        for (size_t i = 0; i < size_; ++i) {
+            data_[i] = T();
+        }
+        size_ = 0;
+    }
+
+    IIteratorPtr<T> GetIterator() const override {
+        return std::make_shared<ArraySequenceIterator<T>>(data_, size_);
+    }
+
+private:
+    void Grow(size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        DynamicArray<T> heap(capacity, resource_);
+        std::move(data_, data_ + size_, heap.GetBegin());
+        heap_ = std::move(heap);
+        data_ = heap_.GetBegin();
+        capacity_ = capacity;
+    }
+
+    void MoveFrom(SmallSequence<T, N>&& v) {
+        if (v.IsInline()) {
+            std::move(v.data_, v.data_ + v.size_, inline_);
+            heap_ = DynamicArray<T>();
+            data_ = inline_;
+            capacity_ = N;
+        } else {
+            heap_ = std::move(v.heap_);
+            data_ = heap_.GetBegin();
+            capacity_ = v.capacity_;
+            v.data_ = v.inline_;
+            v.capacity_ = N;
+        }
+        size_ = v.size_;
+        v.size_ = 0;
+    }
+
+    T inline_[N] = {};
+    DynamicArray<T> heap_;
+    T* data_ = inline_;
+    size_t capacity_ = N;
+    size_t size_ = 0;
+    std::pmr::memory_resource* resource_ = DefaultResource();
+};
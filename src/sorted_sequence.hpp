@@ -3,32 +3,47 @@
 #include <cstddef>
 #include <functional>
 #include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
 
 #include "array_sequence.hpp"
-#include "dynamic_array.hpp"
 #include "fwd.hpp"
+#include "gap_buffer_sequence.hpp"
 #include "isorted_sequence.hpp"
-
-template <typename T, typename Comparator = std::less<T>>
+#include "memory.hpp"
+#include "parallel_sort.hpp"
+#include "stats.hpp"
+#include "string_sort.hpp"
+
+// Storage is ArraySequence<T> or, for runs of inserts close to each other
+// (nearly sorted input), GapBufferSequence<T>.
+template <typename T, typename Comparator = std::less<T>, typename Storage = ArraySequence<T>>
 class SortedSequence : public ISortedSequence<T> {
 public:
     SortedSequence(const T* items, size_t count, Comparator comp = Comparator())
-        : data_(std::make_shared<ArraySequence<T>>(items, count)), comp_(std::move(comp)) {
+        : data_(std::make_shared<Storage>(items, count)), comp_(std::move(comp)) {
         Sort();
     }
 
     SortedSequence(SequencePtr<T> data, Comparator comp = Comparator())
-        : data_(std::make_shared<ArraySequence<T>>(std::move(data))), comp_(std::move(comp)) {
+        : data_(std::make_shared<Storage>(std::move(data))), comp_(std::move(comp)) {
         Sort();
     }
 
     SortedSequence(const Sequence<T>& data, Comparator comp = Comparator())
-        : data_(std::make_shared<ArraySequence<T>>(data)), comp_(std::move(comp)) {
+        : data_(std::make_shared<Storage>(data)), comp_(std::move(comp)) {
+        Sort();
+    }
+
+    SortedSequence(ArraySequence<T>&& data, Comparator comp = Comparator(),
+                   std::pmr::memory_resource* resource = DefaultResource())
+        : data_(MakeShared<Storage>(resource, std::move(data))), comp_(std::move(comp)) {
         Sort();
     }
 
-    SortedSequence(Comparator comp = Comparator())
-        : data_(std::make_shared<ArraySequence<T>>()), comp_(std::move(comp)) {
+    SortedSequence(Comparator comp = Comparator(), std::pmr::memory_resource* resource = DefaultResource())
+        : data_(MakeShared<Storage>(resource, resource)), comp_(std::move(comp)) {
     }
 
     size_t GetLength() const override {
@@ -43,6 +58,11 @@ public:
         return data_->Get(index);
     }
 
+    // Unchecked access for indices that are valid by construction.
+    const T& operator[](size_t index) const {
+        return (*data_)[index];
+    }
+
     const T& GetFirst() const override {
         return data_->GetFirst();
     }
@@ -53,17 +73,30 @@ public:
 
     int IndexOf(const T& value) const override {
         auto pos = LowerBound(value);
-        if (pos == data_->GetLength() || !IsEqual(data_->Get(pos), value)) {
+        if (pos == data_->GetLength() || !IsEqual((*data_)[pos], value)) {
             return -1;
         }
         return pos;
     }
 
     SortedSequencePtr<T> GetSubsequence(size_t startIndex, size_t endIndex) const override {
-        return std::make_shared<SortedSequence<T, Comparator>>(data_->GetSubsequence(startIndex, endIndex), comp_);
+        if (startIndex >= GetLength() || endIndex >= GetLength()) {
+            throw std::out_of_range("Index is out of range: " + std::to_string(startIndex) + " " +
+                                    std::to_string(endIndex) + " " + std::to_string(GetLength()));
+        }
+        if (startIndex > endIndex) {
+            throw std::out_of_range("startIndex is greater than endIndex");
+        }
+        // A range of a sorted sequence is already sorted; ArraySequence slices
+        // also share the buffer.
+        return std::shared_ptr<SortedSequence>(new SortedSequence(
+            AdoptSorted{}, std::make_shared<Storage>(data_->Slice(startIndex, endIndex + 1)), comp_));
     }
 
     size_t LowerBound(const T& value) const override {
+        LAB2_STAT(++stats_.lookups);
+        LAB2_STAT(++stats_.probes);
+        LAB2_STAT(++stats_.comparisons);
         if (data_->GetLength() == 0 || !comp_(data_->GetFirst(), value)) {
             return 0;
         }
@@ -71,7 +104,9 @@ public:
         size_t r = data_->GetLength();
         while (l + 1 < r) {
             size_t mid = (l + r) / 2;
-            if (comp_(data_->Get(mid), value)) {
+            LAB2_STAT(++stats_.probes);
+            LAB2_STAT(++stats_.comparisons);
+            if (comp_((*data_)[mid], value)) {
                 l = mid;
             } else {
                 r = mid;
@@ -80,6 +115,10 @@ public:
         return r;
     }
 
+    void Reserve(size_t capacity) override {
+        data_->Reserve(capacity);
+    }
+
     void Add(const T& value) override {
         auto pos = LowerBound(value);
         data_->InsertAt(value, pos);
@@ -97,53 +136,48 @@ public:
         return data_->GetIterator();
     }
 
+    IIteratorPtr<T> GetRangeIterator(size_t begin, size_t end) const override {
+        return data_->GetRangeIterator(begin, end);
+    }
+
+    LookupStats GetStats() const {
+#ifdef LAB2_STATS
+        return stats_;
+#else
+        return LookupStats{};
+#endif
+    }
+
+    void ResetStats() {
+#ifdef LAB2_STATS
+        stats_ = LookupStats{};
+#endif
+    }
+
 private:
+    struct AdoptSorted {};
+
+    // Adopts `data`, which is already sorted.
+    SortedSequence(AdoptSorted, std::shared_ptr<Storage> data, Comparator comp)
+        : data_(std::move(data)), comp_(std::move(comp)) {
+    }
+
     bool IsEqual(const T& a, const T& b) const {
         return !comp_(a, b) && !comp_(b, a);
     }
 
     void Sort() {
-        size_t n = data_->GetLength();
-        if (n < 2) {
-            return;
-        }
-        DynamicArray<T> buffer(n);
-        MergeSort(0, n, buffer);
-    }
-
-    void MergeSort(size_t l, size_t r, DynamicArray<T>& buffer) {
-        if (r - l <= 1) {
-            return;
-        }
-        size_t mid = (l + r) / 2;
-        MergeSort(l, mid, buffer);
-        MergeSort(mid, r, buffer);
-        Merge(l, mid, r, buffer);
-    }
-
-    void Merge(size_t l, size_t mid, size_t r, DynamicArray<T>& buffer) {
-        size_t i = l;
-        size_t j = mid;
-        size_t k = 0;
-        while (i < mid && j < r) {
-            if (comp_(data_->Get(j), data_->Get(i))) {
-                buffer.Set(data_->Get(j++), k++);
-            } else {
-                buffer.Set(data_->Get(i++), k++);
-            }
-        }
-        while (i < mid) {
-            buffer.Set(data_->Get(i++), k++);
-        }
-        while (j < r) {
-            buffer.Set(data_->Get(j++), k++);
-        }
-        for (size_t t = 0; t < k; ++t) {
-            data_->Set(buffer.Get(t), l + t);
+        if constexpr (StringSortKey<T, Comparator>::kEnabled) {
+            StringRadixSort<T, Comparator>(data_->GetBegin(), data_->GetLength());
+        } else {
+            ParallelMergeSort(data_->GetBegin(), data_->GetLength(), comp_);
         }
     }
 
 private:
-    SequencePtr<T> data_;
+    std::shared_ptr<Storage> data_;
     Comparator comp_;
+#ifdef LAB2_STATS
+    mutable LookupStats stats_;
+#endif
 };
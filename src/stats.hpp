@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Hot-path instrumentation. Counters are compiled in only when LAB2_STATS is
+// defined (CMake option LAB2_STATS); otherwise LAB2_STAT discards its argument,
+// the counter members do not exist and every GetStats() reports zeros.
+#ifdef LAB2_STATS
+inline constexpr bool kStatsEnabled = true;
+#define LAB2_STAT(statement) statement
+#else
+inline constexpr bool kStatsEnabled = false;
+#define LAB2_STAT(statement) ((void)0)
+#endif
+
+// Chains of this length or longer share the last histogram bucket.
+inline constexpr size_t kChainHistogramSize = 16;
+
+struct LookupStats {
+    uint64_t lookups = 0;      // Get/ContainsKey/Add/Remove (LowerBound for sequences)
+    uint64_t probes = 0;       // buckets or array positions visited
+    uint64_t comparisons = 0;  // key comparisons
+};
+
+// Queries answered by an approximate-membership filter in front of a
+// dictionary: rejected ones never reach it, false positives pass the filter
+// and then miss.
+struct FilterStats {
+    uint64_t queries = 0;
+    uint64_t rejected = 0;
+    uint64_t false_positives = 0;
+};
+
+struct HashTableStats {
+    LookupStats lookup;
+    uint64_t rehashes = 0;
+    uint64_t rehash_ns = 0;
+    // Structural, so filled in whether or not LAB2_STATS is defined.
+    uint64_t chain_lengths[kChainHistogramSize] = {};
+};
+
+// Throughput of one pipeline stage. Time is inclusive: a stage pulls from
+// its source inside Read, so it contains the time of the stages upstream.
+struct StageStats {
+    uint64_t items = 0;
+    uint64_t bytes = 0;
+    uint64_t ns = 0;
+};
+
+struct PipelineStats {
+    StageStats lexer;
+    StageStats lines;
+    StageStats pages;
+};
+
+// Adds the lifetime of the object to `ns`.
+class StatTimer {
+public:
+    explicit StatTimer(uint64_t& ns) : ns_(ns), start_(std::chrono::steady_clock::now()) {
+    }
+
+    ~StatTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    StatTimer(const StatTimer&) = delete;
+    StatTimer& operator=(const StatTimer&) = delete;
+
+private:
+    uint64_t& ns_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+inline void WriteJson(std::ostream& out, const LookupStats& stats) {
+    out << "{\"lookups\":" << stats.lookups << ",\"probes\":" << stats.probes
+        << ",\"comparisons\":" << stats.comparisons << "}";
+}
+
+inline void WriteJson(std::ostream& out, const FilterStats& stats) {
+    out << "{\"queries\":" << stats.queries << ",\"rejected\":" << stats.rejected
+        << ",\"false_positives\":" << stats.false_positives << "}";
+}
+
+inline void WriteJson(std::ostream& out, const HashTableStats& stats) {
+    out << "{\"lookup\":";
+    WriteJson(out, stats.lookup);
+    out << ",\"rehashes\":" << stats.rehashes << ",\"rehash_ns\":" << stats.rehash_ns << ",\"chain_lengths\":[";
+    for (size_t i = 0; i < kChainHistogramSize; ++i) {
+        out << (i == 0 ? "" : ",") << stats.chain_lengths[i];
+    }
+    out << "]}";
+}
+
+inline void WriteJson(std::ostream& out, const StageStats& stats) {
+    out << "{\"items\":" << stats.items << ",\"bytes\":" << stats.bytes << ",\"ns\":" << stats.ns << "}";
+}
+
+inline void WriteJson(std::ostream& out, const PipelineStats& stats) {
+    out << "{\"lexer\":";
+    WriteJson(out, stats.lexer);
+    out << ",\"lines\":";
+    WriteJson(out, stats.lines);
+    out << ",\"pages\":";
+    WriteJson(out, stats.pages);
+    out << "}";
+}
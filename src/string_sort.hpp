@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "array_sequence.hpp"
+#include "dynamic_array.hpp"
+#include "idictionary.hpp"
+#include "parallel.hpp"
+
+// Selects the radix sort path for element/comparator pairs whose order is
+// plain byte-wise string order; Get returns the string key of an element.
+template <typename T, typename Comparator>
+struct StringSortKey {
+    static constexpr bool kEnabled = false;
+};
+
+template <>
+struct StringSortKey<std::string, std::less<std::string>> {
+    static constexpr bool kEnabled = true;
+
+    static const std::string& Get(const std::string& value) {
+        return value;
+    }
+};
+
+template <>
+struct StringSortKey<std::string, std::less<>> : StringSortKey<std::string, std::less<std::string>> {};
+
+template <typename Value>
+struct StringSortKey<KeyValue<std::string, Value>, KeyLess<std::string, Value>> {
+    static constexpr bool kEnabled = true;
+
+    static const std::string& Get(const KeyValue<std::string, Value>& value) {
+        return value.key;
+    }
+};
+
+template <typename Value>
+struct StringSortKey<const KeyValue<std::string, Value>*, KeyPtrLess<std::string, Value>> {
+    static constexpr bool kEnabled = true;
+
+    static const std::string& Get(const KeyValue<std::string, Value>* value) {
+        return value->key;
+    }
+};
+
+namespace string_sort_detail {
+
+constexpr size_t kInsertionThreshold = 32;
+constexpr size_t kParallelThreshold = 1 << 14;
+constexpr size_t kBuckets = 257;
+
+// The key bytes are cached next to the element index so that the sort never
+// goes through std::string or the element itself.
+struct Item {
+    const char* str = nullptr;
+    size_t length = 0;
+    size_t index = 0;
+};
+
+inline bool SuffixLess(const Item& a, const Item& b, size_t depth) {
+    size_t common = (a.length < b.length ? a.length : b.length) - depth;
+    int cmp = std::memcmp(a.str + depth, b.str + depth, common);
+    return cmp < 0 || (cmp == 0 && a.length < b.length);
+}
+
+inline void InsertionSort(Item* items, size_t n, size_t depth) {
+    for (size_t i = 1; i < n; ++i) {
+        Item value = items[i];
+        size_t j = i;
+        while (j > 0 && SuffixLess(value, items[j - 1], depth)) {
+            items[j] = items[j - 1];
+            --j;
+        }
+        items[j] = value;
+    }
+}
+
+// Stable counting pass on the byte at `depth` (bucket 0 holds the keys that
+// end there). The byte of every key is read once into `cache`.
+inline void Distribute(Item* items, Item* tmp, uint16_t* cache, size_t n, size_t depth, size_t* bounds) {
+    size_t counts[kBuckets] = {};
+    for (size_t i = 0; i < n; ++i) {
+        uint16_t c = depth < items[i].length ? static_cast<unsigned char>(items[i].str[depth]) + 1 : 0;
+        cache[i] = c;
+        ++counts[c];
+    }
+    size_t sum = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+        bounds[b] = sum;
+        sum += counts[b];
+    }
+    bounds[kBuckets] = sum;
+    size_t pos[kBuckets];
+    std::memcpy(pos, bounds, sizeof(pos));
+    for (size_t i = 0; i < n; ++i) {
+        tmp[pos[cache[i]]++] = items[i];
+    }
+    std::memcpy(items, tmp, n * sizeof(Item));
+}
+
+// A run of items left to sort from byte `depth` on.
+struct Range {
+    size_t begin = 0;
+    size_t size = 0;
+    size_t depth = 0;
+};
+
+// The pending runs live on a heap stack rather than the call stack: nested
+// prefixes ("a", "aa", "aaa", ...) split off one key per byte, so recursion
+// would go as deep as the longest key.
+inline void MsdSort(Item* items, Item* tmp, uint16_t* cache, size_t n, size_t depth) {
+    ArraySequence<Range> work;
+    work.Append(Range{0, n, depth});
+    size_t bounds[kBuckets + 1];
+    while (work.GetLength() > 0) {
+        Range range = work.GetLast();
+        work.EraseAt(work.GetLength() - 1);
+        Item* part = items + range.begin;
+        if (range.size < kInsertionThreshold) {
+            InsertionSort(part, range.size, range.depth);
+            continue;
+        }
+        while (true) {
+            Distribute(part, tmp + range.begin, cache + range.begin, range.size, range.depth, bounds);
+            size_t first = cache[range.begin];
+            // A shared byte only extends the common prefix: continue in place
+            // rather than pushing a run per byte of a long prefix.
+            if (first == 0 || bounds[first + 1] - bounds[first] != range.size) {
+                break;
+            }
+            ++range.depth;
+        }
+        for (size_t b = 1; b < kBuckets; ++b) {
+            size_t size = bounds[b + 1] - bounds[b];
+            if (size > 1) {
+                work.Append(Range{range.begin + bounds[b], size, range.depth + 1});
+            }
+        }
+    }
+}
+
+}  // namespace string_sort_detail
+
+// Stable MSD radix sort for string-keyed elements. Keys are bucketed byte by
+// byte with small buckets finished by insertion sort; the buckets of the
+// first byte are sorted on up to `threads` threads. Elements are moved into
+// place once at the end.
+template <typename T, typename Comparator>
+void StringRadixSort(T* data, size_t n, size_t threads = GetThreadCount()) {
+    using namespace string_sort_detail;
+    using Key = StringSortKey<T, Comparator>;
+    if (n < 2) {
+        return;
+    }
+    DynamicArray<Item> items(n);
+    DynamicArray<Item> tmp(n);
+    DynamicArray<uint16_t> cache(n);
+    Item* it = items.GetBegin();
+    for (size_t i = 0; i < n; ++i) {
+        const std::string& key = Key::Get(data[i]);
+        it[i] = Item{key.data(), key.size(), i};
+    }
+
+    if (n < kParallelThreshold || threads <= 1) {
+        MsdSort(it, tmp.GetBegin(), cache.GetBegin(), n, 0);
+    } else {
+        size_t bounds[kBuckets + 1];
+        Distribute(it, tmp.GetBegin(), cache.GetBegin(), n, 0, bounds);
+        ParallelFor(kBuckets - 1, threads, [&](size_t bucket) {
+            size_t begin = bounds[bucket + 1];
+            size_t size = bounds[bucket + 2] - begin;
+            if (size > 1) {
+                MsdSort(it + begin, tmp.GetBegin() + begin, cache.GetBegin() + begin, size, 1);
+            }
+        });
+    }
+
+    DynamicArray<T> sorted(n);
+    T* out = sorted.GetBegin();
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = std::move(data[it[i].index]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        data[i] = std::move(out[i]);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+
+#include "dynamic_array.hpp"
+#include "utf8.hpp"
+
+struct TextEstimate {
+    size_t words = 0;
+    size_t distinct = 0;
+};
+
+// Counts the words of `text` and estimates how many of them are distinct
+// with linear counting: words are hashed into a bitmap of m bits and
+// distinct ~ m * ln(m / empty_bits). The bitmap has about one bit per four
+// bytes of text, which keeps the error within a few percent for any
+// vocabulary the text can hold. Words are split as the lexer splits them
+// and hashed in place, with no per-word allocation.
+inline TextEstimate EstimateText(std::string_view text) {
+    size_t bits = 64;
+    while (bits < text.size() / 4) {
+        bits *= 2;
+    }
+    DynamicArray<uint64_t> bitmap(bits / 64);
+    uint64_t* words = bitmap.GetBegin();
+
+    TextEstimate res;
+    size_t i = SkipSpace(text, 0);
+    while (i < text.size()) {
+        size_t end = FindSpace(text, i);
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (; i < end; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(text[i])) * 0x100000001b3ULL;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        size_t bit = hash & (bits - 1);
+        words[bit / 64] |= uint64_t{1} << (bit % 64);
+        ++res.words;
+        i = SkipSpace(text, end);
+    }
+
+    size_t empty = 0;
+    for (size_t w = 0; w < bits / 64; ++w) {
+        empty += 64 - static_cast<size_t>(std::popcount(words[w]));
+    }
+    if (empty == 0) {
+        res.distinct = res.words;
+    } else {
+        double m = static_cast<double>(bits);
+        auto estimate = static_cast<size_t>(m * std::log(m / static_cast<double>(empty)) + 0.5);
+        res.distinct = estimate < res.words ? estimate : res.words;
+    }
+    return res;
+}
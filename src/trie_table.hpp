@@ -0,0 +1,308 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include "array_sequence.hpp"
+#include "bit_vector.hpp"
+#include "hash_table.hpp"
+#include "isorted_dictionary.hpp"
+#include "sequence_view.hpp"
+#include "sorted_sequence.hpp"
+
+template <typename Value>
+class TrieTable;
+
+// Depth-first walk over a TrieTable, yielding entries in key order. The walk
+// keeps the path from the root so that siblings and parents are reachable
+// without parent pointers in the trie itself.
+template <typename Value>
+class TrieTableIterator : public IIterator<KeyValue<std::string, Value>> {
+    struct Frame {
+        size_t node = 0;
+        size_t end_edge = 0;
+    };
+
+public:
+    TrieTableIterator(const TrieTable<Value>& trie, const std::string& lo, const std::string* hi)
+        : trie_(trie), has_hi_(hi != nullptr) {
+        if (has_hi_) {
+            hi_ = *hi;
+        }
+        stack_.Append(Frame{0, 0});
+        valid_ = Seek(lo);
+        Update();
+    }
+
+    bool HasNext() const override {
+        return valid_;
+    }
+
+    bool Next() override {
+        if (!valid_) {
+            return false;
+        }
+        auto [begin, end] = trie_.EdgeRange(stack_.GetLast().node);
+        if (begin < end) {
+            Push(begin, end);
+            valid_ = DescendToTerminal();
+        } else {
+            valid_ = AdvanceUp();
+        }
+        Update();
+        return true;
+    }
+
+    const KeyValue<std::string, Value>& GetCurrentItem() const override {
+        if (!HasNext()) {
+            throw std::out_of_range("No next element");
+        }
+        return current_;
+    }
+
+    bool TryGetCurrentItem(KeyValue<std::string, Value>& element) const override {
+        if (!HasNext()) {
+            return false;
+        }
+        element = current_;
+        return true;
+    }
+
+private:
+    void Push(size_t edge, size_t end_edge) {
+        key_.push_back(static_cast<char>(trie_.labels_[edge]));
+        stack_.Append(Frame{edge + 1, end_edge});
+    }
+
+    void Pop() {
+        key_.pop_back();
+        stack_.EraseAt(stack_.GetLength() - 1);
+    }
+
+    bool DescendToTerminal() {
+        while (!trie_.terminal_.Get(stack_.GetLast().node)) {
+            auto [begin, end] = trie_.EdgeRange(stack_.GetLast().node);
+            if (begin == end) {
+                return false;
+            }
+            Push(begin, end);
+        }
+        return true;
+    }
+
+    // Leaves the current subtree and moves to the next terminal in key order.
+    bool AdvanceUp() {
+        while (stack_.GetLength() > 1) {
+            Frame top = stack_.GetLast();
+            size_t next_edge = top.node;
+            Pop();
+            if (next_edge < top.end_edge) {
+                Push(next_edge, top.end_edge);
+                return DescendToTerminal();
+            }
+        }
+        return false;
+    }
+
+    bool Seek(const std::string& lo) {
+        for (char ch : lo) {
+            auto c = static_cast<unsigned char>(ch);
+            auto [begin, end] = trie_.EdgeRange(stack_.GetLast().node);
+            size_t e = trie_.LowerLabel(begin, end, c);
+            if (e == end) {
+                return AdvanceUp();
+            }
+            Push(e, end);
+            if (trie_.labels_[e] != c) {
+                return DescendToTerminal();
+            }
+        }
+        return DescendToTerminal();
+    }
+
+    void Update() {
+        if (valid_ && has_hi_ && key_ >= hi_) {
+            valid_ = false;
+        }
+        if (valid_) {
+            current_.key = key_;
+            current_.value = trie_.ValueAt(stack_.GetLast().node);
+        }
+    }
+
+    const TrieTable<Value>& trie_;
+    ArraySequence<Frame> stack_;
+    std::string key_;
+    bool has_hi_;
+    std::string hi_;
+    bool valid_ = false;
+    KeyValue<std::string, Value> current_;
+};
+
+// Immutable LOUDS-encoded trie over string keys. Nodes are numbered in
+// breadth-first order; node i is described by a run of ones (one per child
+// edge) followed by a zero, edge e carries labels_[e] and leads to node e + 1.
+// Values are stored for terminal nodes only, in node order.
+template <typename Value>
+class TrieTable : public ISortedDictionary<std::string, Value> {
+    using Pair = KeyValue<std::string, Value>;
+
+public:
+    // Backends with a Staging type are filled through it by BuildBook and
+    // converted once indexing is complete.
+    using Staging = HashTable<std::string, Value>;
+
+    explicit TrieTable(const IDictionary<std::string, Value>& source) {
+        ArraySequence<Pair> pairs;
+        bool sorted = true;
+        for (auto it = source.GetIterator(); it->HasNext(); it->Next()) {
+            const auto& kv = it->GetCurrentItem();
+            if (pairs.GetLength() > 0 && !(pairs.GetLast().key < kv.key)) {
+                sorted = false;
+            }
+            pairs.Append(kv);
+        }
+        if (sorted) {
+            Build(pairs);
+        } else {
+            SortedSequence<Pair, KeyLess<std::string, Value>> ordered(std::move(pairs));
+            Build(ordered);
+        }
+    }
+
+    size_t GetCount() const override {
+        return values_.GetLength();
+    }
+
+    size_t GetCapacity() const override {
+        return values_.GetLength();
+    }
+
+    size_t GetByteSize() const {
+        return louds_.GetByteSize() + terminal_.GetByteSize() + labels_.GetLength() +
+               values_.GetLength() * sizeof(Value);
+    }
+
+    const Value& Get(const std::string& key) const override {
+        size_t node = 0;
+        if (!Find(key, node)) {
+            throw std::out_of_range("No such key");
+        }
+        return ValueAt(node);
+    }
+
+    bool ContainsKey(const std::string& key) const override {
+        size_t node = 0;
+        return Find(key, node);
+    }
+
+    void Add(const std::string&, const Value&) override {
+        throw std::logic_error("TrieTable is immutable");
+    }
+
+    void Remove(const std::string&) override {
+        throw std::logic_error("TrieTable is immutable");
+    }
+
+    SequencePtr<std::string> GetKeys() const override {
+        return CopyKeys(*this);
+    }
+
+    SequencePtr<Value> GetValues() const override {
+        return CopyValues(*this);
+    }
+
+    IIteratorPtr<Pair> GetIterator() const override {
+        return std::make_shared<TrieTableIterator<Value>>(*this, std::string(), nullptr);
+    }
+
+    IIteratorPtr<Pair> Range(const std::string& lo, const std::string& hi) const override {
+        return std::make_shared<TrieTableIterator<Value>>(*this, lo, &hi);
+    }
+
+    IIteratorPtr<Pair> RangeFrom(const std::string& lo) const override {
+        return std::make_shared<TrieTableIterator<Value>>(*this, lo, nullptr);
+    }
+
+private:
+    friend class TrieTableIterator<Value>;
+
+    struct Span {
+        size_t begin = 0;
+        size_t end = 0;
+        size_t depth = 0;
+    };
+
+    // Breadth-first construction: every queued span is a run of sorted keys
+    // sharing their first `depth` bytes, i.e. one trie node.
+    template <typename Sorted>
+    void Build(const Sorted& pairs) {
+        ArraySequence<Span> queue;
+        queue.Append(Span{0, pairs.GetLength(), 0});
+        for (size_t head = 0; head < queue.GetLength(); ++head) {
+            Span span = queue.Get(head);
+            size_t i = span.begin;
+            bool terminal = i < span.end && pairs[i].key.size() == span.depth;
+            terminal_.PushBack(terminal);
+            if (terminal) {
+                values_.Append(pairs[i].value);
+                ++i;
+            }
+            while (i < span.end) {
+                auto label = static_cast<unsigned char>(pairs[i].key[span.depth]);
+                size_t j = i + 1;
+                while (j < span.end && static_cast<unsigned char>(pairs[j].key[span.depth]) == label) {
+                    ++j;
+                }
+                labels_.Append(label);
+                louds_.PushBack(true);
+                queue.Append(Span{i, j, span.depth + 1});
+                i = j;
+            }
+            louds_.PushBack(false);
+        }
+        louds_.Build();
+        terminal_.Build();
+    }
+
+    std::pair<size_t, size_t> EdgeRange(size_t node) const {
+        size_t start = node == 0 ? 0 : louds_.Select0(node - 1) + 1;
+        size_t stop = louds_.Select0(node);
+        return {start - node, stop - node};
+    }
+
+    size_t LowerLabel(size_t begin, size_t end, unsigned char label) const {
+        while (begin < end) {
+            size_t mid = (begin + end) / 2;
+            if (labels_[mid] < label) {
+                begin = mid + 1;
+            } else {
+                end = mid;
+            }
+        }
+        return begin;
+    }
+
+    bool Find(const std::string& key, size_t& node) const {
+        node = 0;
+        for (char ch : key) {
+            auto c = static_cast<unsigned char>(ch);
+            auto [begin, end] = EdgeRange(node);
+            size_t e = LowerLabel(begin, end, c);
+            if (e == end || labels_[e] != c) {
+                return false;
+            }
+            node = e + 1;
+        }
+        return terminal_.Get(node);
+    }
+
+    const Value& ValueAt(size_t node) const {
+        return values_[terminal_.Rank1(node)];
+    }
+
+    BitVector louds_;
+    BitVector terminal_;
+    ArraySequence<unsigned char> labels_;
+    ArraySequence<Value> values_;
+};
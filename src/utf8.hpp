@@ -0,0 +1,295 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// UTF-8 helpers for the lexer and for index keys. Malformed input is never
+// rejected: a byte that does not start a valid sequence is taken as a
+// one-byte character of its own (decoded as U+FFFD, so it is never a space
+// or punctuation), and arbitrary bytes pass through unchanged.
+
+inline constexpr char32_t kReplacementCharacter = 0xFFFD;
+
+namespace utf8_detail {
+
+struct Range {
+    char32_t lo;
+    char32_t hi;
+};
+
+// Whitespace outside ASCII (Unicode White_Space).
+inline constexpr Range kSpaces[] = {
+    {0x0085, 0x0085}, {0x00A0, 0x00A0}, {0x1680, 0x1680}, {0x2000, 0x200A},
+    {0x2028, 0x2029}, {0x202F, 0x202F}, {0x205F, 0x205F}, {0x3000, 0x3000},
+};
+
+// Common punctuation outside ASCII: Latin-1 marks, general punctuation
+// (dashes, quotes, ellipsis), CJK full stops and brackets.
+inline constexpr Range kPunctuation[] = {
+    {0x00A1, 0x00A1}, {0x00A7, 0x00A7}, {0x00AB, 0x00AB}, {0x00B6, 0x00B7}, {0x00BB, 0x00BB},
+    {0x00BF, 0x00BF}, {0x2010, 0x2027}, {0x2030, 0x205E}, {0x3001, 0x3003}, {0x3008, 0x3011},
+};
+
+struct FoldRange {
+    char32_t lo;
+    char32_t hi;
+    char32_t delta;
+};
+
+// Upper -> lower case for Latin-1, Greek and Cyrillic; ASCII is handled inline.
+inline constexpr FoldRange kFolds[] = {
+    {0x00C0, 0x00D6, 0x20}, {0x00D8, 0x00DE, 0x20}, {0x0391, 0x03A1, 0x20},
+    {0x03A3, 0x03AB, 0x20}, {0x0400, 0x040F, 0x50}, {0x0410, 0x042F, 0x20},
+};
+
+template <size_t N>
+constexpr bool InRanges(const Range (&ranges)[N], char32_t cp) {
+    for (const auto& r : ranges) {
+        if (cp < r.lo) {
+            return false;
+        }
+        if (cp <= r.hi) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sequence length by lead byte: 0 for continuation and invalid lead bytes.
+struct LengthTable {
+    uint8_t length[256] = {};
+
+    constexpr LengthTable() {
+        for (int b = 0; b < 0x80; ++b) {
+            length[b] = 1;
+        }
+        for (int b = 0xC2; b < 0xE0; ++b) {
+            length[b] = 2;
+        }
+        for (int b = 0xE0; b < 0xF0; ++b) {
+            length[b] = 3;
+        }
+        for (int b = 0xF0; b < 0xF5; ++b) {
+            length[b] = 4;
+        }
+    }
+};
+
+inline constexpr LengthTable kLengths;
+
+}  // namespace utf8_detail
+
+inline size_t Utf8SequenceLength(unsigned char lead) {
+    return utf8_detail::kLengths.length[lead];
+}
+
+// Decodes the character at the start of [p, p + size). Returns its length in
+// bytes, always at least 1; a malformed sequence is one byte of U+FFFD.
+inline size_t DecodeUtf8(const char* p, size_t size, char32_t& cp) {
+    auto lead = static_cast<unsigned char>(p[0]);
+    size_t length = Utf8SequenceLength(lead);
+    if (length == 1) {
+        cp = lead;
+        return 1;
+    }
+    if (length == 0 || length > size) {
+        cp = kReplacementCharacter;
+        return 1;
+    }
+    char32_t value = lead & (0x7F >> length);
+    for (size_t i = 1; i < length; ++i) {
+        auto byte = static_cast<unsigned char>(p[i]);
+        if ((byte & 0xC0) != 0x80) {
+            cp = kReplacementCharacter;
+            return 1;
+        }
+        value = (value << 6) | (byte & 0x3F);
+    }
+    // Overlong three/four-byte forms, surrogates and values past U+10FFFF.
+    if ((length == 3 && value < 0x800) || (length == 4 && (value < 0x10000 || value > 0x10FFFF)) ||
+        (value >= 0xD800 && value <= 0xDFFF)) {
+        cp = kReplacementCharacter;
+        return 1;
+    }
+    cp = value;
+    return length;
+}
+
+inline void AppendUtf8(std::string& out, char32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+inline bool IsAsciiSpace(unsigned char ch) {
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+inline bool IsSpace(char32_t cp) {
+    return cp < 0x80 ? IsAsciiSpace(static_cast<unsigned char>(cp)) : utf8_detail::InRanges(utf8_detail::kSpaces, cp);
+}
+
+inline bool IsPunctuation(char32_t cp) {
+    if (cp < 0x80) {
+        return (cp >= '!' && cp <= '/') || (cp >= ':' && cp <= '@') || (cp >= '[' && cp <= '`') ||
+               (cp >= '{' && cp <= '~');
+    }
+    return utf8_detail::InRanges(utf8_detail::kPunctuation, cp);
+}
+
+inline char32_t FoldCase(char32_t cp) {
+    if (cp < 0x80) {
+        return (cp >= 'A' && cp <= 'Z') ? cp + 0x20 : cp;
+    }
+    for (const auto& r : utf8_detail::kFolds) {
+        if (cp < r.lo) {
+            break;
+        }
+        if (cp <= r.hi) {
+            return cp + r.delta;
+        }
+    }
+    return cp;
+}
+
+// Offset of the first non-space character of `text` at or after `pos`.
+inline size_t SkipSpace(std::string_view text, size_t pos) {
+    while (pos < text.size()) {
+        auto ch = static_cast<unsigned char>(text[pos]);
+        if (ch < 0x80) {
+            if (!IsAsciiSpace(ch)) {
+                return pos;
+            }
+            ++pos;
+            continue;
+        }
+        char32_t cp;
+        size_t length = DecodeUtf8(text.data() + pos, text.size() - pos, cp);
+        if (!IsSpace(cp)) {
+            return pos;
+        }
+        pos += length;
+    }
+    return text.size();
+}
+
+// Offset of the first space character of `text` at or after `pos`. With SSE2
+// sixteen bytes are checked per step: one compare pass finds ASCII spaces and
+// the sign bits flag non-ASCII bytes, which drop to the decoding path for a
+// single character before the vector loop resumes.
+inline size_t FindSpace(std::string_view text, size_t pos) {
+    const char* data = text.data();
+    const size_t size = text.size();
+    while (pos < size) {
+#ifdef __SSE2__
+        const __m128i blank = _mm_set1_epi8(' ');
+        const __m128i below_tab = _mm_set1_epi8('\t' - 1);
+        const __m128i above_cr = _mm_set1_epi8('\r' + 1);
+        while (pos + 16 <= size) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            __m128i control = _mm_and_si128(_mm_cmpgt_epi8(v, below_tab), _mm_cmplt_epi8(v, above_cr));
+            __m128i space = _mm_or_si128(_mm_cmpeq_epi8(v, blank), control);
+            auto stop = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(space, v)));
+            if (stop != 0) {
+                pos += std::countr_zero(stop);
+                break;
+            }
+            pos += 16;
+        }
+        if (pos >= size) {
+            break;
+        }
+#endif
+        auto ch = static_cast<unsigned char>(data[pos]);
+        if (ch < 0x80) {
+            if (IsAsciiSpace(ch)) {
+                return pos;
+            }
+            ++pos;
+            continue;
+        }
+        char32_t cp;
+        size_t length = DecodeUtf8(data + pos, size - pos, cp);
+        if (IsSpace(cp)) {
+            return pos;
+        }
+        pos += length;
+    }
+    return size;
+}
+
+// How words are turned into index keys.
+struct KeyOptions {
+    bool strip_punctuation = false;  // drop leading and trailing punctuation
+    bool fold_case = false;          // lower-case Latin, Greek and Cyrillic letters
+};
+
+// The index key for `word`; empty if nothing but punctuation is left.
+inline std::string NormalizeKey(std::string_view word, const KeyOptions& options) {
+    if (!options.strip_punctuation && !options.fold_case) {
+        return std::string(word);
+    }
+    size_t begin = 0;
+    size_t end = word.size();
+    if (options.strip_punctuation) {
+        char32_t cp;
+        while (begin < end) {
+            size_t length = DecodeUtf8(word.data() + begin, end - begin, cp);
+            if (!IsPunctuation(cp)) {
+                break;
+            }
+            begin += length;
+        }
+        // Walk back to the start of the last character and test it.
+        while (end > begin) {
+            size_t start = end - 1;
+            while (start > begin && (static_cast<unsigned char>(word[start]) & 0xC0) == 0x80 && end - start < 4) {
+                --start;
+            }
+            size_t length = DecodeUtf8(word.data() + start, end - start, cp);
+            if (start + length != end) {
+                start = end - 1;
+                cp = kReplacementCharacter;
+            }
+            if (!IsPunctuation(cp)) {
+                break;
+            }
+            end = start;
+        }
+    }
+    if (!options.fold_case) {
+        return std::string(word.substr(begin, end - begin));
+    }
+    std::string key;
+    key.reserve(end - begin);
+    for (size_t i = begin; i < end;) {
+        char32_t cp;
+        size_t length = DecodeUtf8(word.data() + i, end - i, cp);
+        if (length == 1 && cp >= 0x80) {
+            key.push_back(word[i]);
+        } else {
+            AppendUtf8(key, FoldCase(cp));
+        }
+        i += length;
+    }
+    return key;
+}
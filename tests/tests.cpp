@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <atomic>
 #include <catch2/catch_test_macros.hpp>
+#include <map>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
@@ -6,10 +9,21 @@
 
 #include "alphabet_index.hpp"
 #include "array_sequence.hpp"
+#include "bloom_filter.hpp"
+#include "bplus_tree.hpp"
+#include "buffered_writer.hpp"
+#include "corpus.hpp"
+#include "filtered_dictionary.hpp"
 #include "flat_table.hpp"
 #include "hash_table.hpp"
 #include "list_sequence.hpp"
+#include "parallel_sort.hpp"
+#include "perfect_hash_table.hpp"
+#include "postings.hpp"
+#include "small_sequence.hpp"
 #include "sorted_sequence.hpp"
+#include "string_sort.hpp"
+#include "trie_table.hpp"
 
 template <typename T>
 std::vector<T> ToVector(const Sequence<T>& seq) {
@@ -323,6 +337,18 @@ TEST_CASE("FlatTable") {
         auto pairs = ToPairs(dict);
         REQUIRE(pairs.front().key == 1);
         REQUIRE(pairs.back().key == 3);
+
+        // Entries are read on demand, so skipped positions are never copied.
+        auto it = dict.GetIterator();
+        REQUIRE(it->GetCurrentItem().value == 10);
+        it->Next();
+        it->Next();
+        REQUIRE(it->GetCurrentItem().key == 3);
+        KeyValue<int, int> last;
+        REQUIRE(it->TryGetCurrentItem(last));
+        REQUIRE(last.value == 30);
+        it->Next();
+        REQUIRE_THROWS_AS(it->GetCurrentItem(), std::out_of_range);
     }
 
     SECTION("GetFail") {
@@ -412,3 +438,1124 @@ TEST_CASE("LineSizeWords") {
     const auto& first_line = page.lines->GetFirst();
     REQUIRE(ToVector(first_line.words) == std::vector<std::string>({"a", "b"}));
 }
+
+TEST_CASE("Postings") {
+    PostingList list;
+    for (int page = 1; page <= 500; page += 3) {
+        list.Add(page);
+        list.Add(page);
+    }
+    REQUIRE(list.GetCount() == 167);
+    REQUIRE(list.GetFirstPage() == 1);
+    REQUIRE(list.GetLastPage() == 499);
+    REQUIRE_THROWS_AS(list.Add(5), std::invalid_argument);
+
+    PostingCursor cur(list);
+    cur.SkipTo(301);
+    REQUIRE(cur.GetCurrent().page == 301);
+    cur.SkipTo(302);
+    REQUIRE(cur.GetCurrent().page == 304);
+    cur.SkipTo(1000);
+    REQUIRE_FALSE(cur.IsValid());
+
+    auto evens = std::make_shared<PostingList>();
+    for (int page = 2; page <= 500; page += 2) {
+        evens->Add(page);
+    }
+    ArraySequence<PostingListPtr> lists;
+    lists.Append(std::make_shared<PostingList>(list));
+    lists.Append(evens);
+    auto common = ToVector(IntersectPages(lists));
+    REQUIRE(common.size() == 83);
+    REQUIRE(common.front() == 4);
+    REQUIRE(common.back() == 496);
+
+    // A page whose postings span several blocks is entered at its first one.
+    PostingList lines(true);
+    lines.Add(1, 1);
+    for (int line = 1; line <= 100; ++line) {
+        lines.Add(2, line);
+    }
+    PostingCursor line_cur(lines);
+    line_cur.SkipTo(2);
+    REQUIRE(line_cur.GetCurrent().page == 2);
+    REQUIRE(line_cur.GetCurrent().line == 1);
+}
+
+TEST_CASE("Concordance") {
+    std::string text = "a b a c b a";
+    using Conc = HashTable<std::string, PostingListPtr>;
+    auto book = BuildConcordanceBook<FlatTable<std::string, int>, Conc>(
+        text, 2, AlphabetIndexMode::Words, 0, ConcordanceOptions{.with_lines = true, .keys = {}});
+    REQUIRE(book.index->Get("a") == 1);
+    REQUIRE(book.index->Get("c") == 3);
+
+    std::vector<Posting> a;
+    for (auto it = book.concordance->Get("a")->GetIterator(); it->HasNext(); it->Next()) {
+        a.push_back(it->GetCurrentItem());
+    }
+    REQUIRE(a == std::vector<Posting>({{1, 1}, {2, 2}, {4, 1}}));
+
+    ArraySequence<PostingListPtr> lists;
+    lists.Append(book.concordance->Get("a"));
+    lists.Append(book.concordance->Get("b"));
+    REQUIRE(ToVector(IntersectPages(lists)) == std::vector<int>({2}));
+
+    std::ostringstream out;
+    WriteBook(book, out);
+    REQUIRE(out.str().find("Concordance:\n") != std::string::npos);
+    REQUIRE(out.str().find("a -> 1:1, 2:2, 4:1\n") != std::string::npos);
+}
+
+TEST_CASE("FlatRange") {
+    FlatTable<std::string, int> dict;
+    for (const char* w : {"apple", "apricot", "banana", "band", "bandit", "cherry", "ap"}) {
+        dict.Add(w, 1);
+    }
+    auto keys = [](IIteratorPtr<KeyValue<std::string, int>> it) {
+        std::vector<std::string> res;
+        for (; it->HasNext(); it->Next()) {
+            res.push_back(it->GetCurrentItem().key);
+        }
+        return res;
+    };
+
+    REQUIRE(keys(dict.ScanPrefix("ap")) == std::vector<std::string>({"ap", "apple", "apricot"}));
+    REQUIRE(keys(dict.ScanPrefix("band")) == std::vector<std::string>({"band", "bandit"}));
+    REQUIRE(keys(dict.ScanPrefix("x")).empty());
+    REQUIRE(keys(dict.ScanPrefix("")).size() == dict.GetCount());
+    REQUIRE(keys(dict.Range("apricot", "bandit")) == std::vector<std::string>({"apricot", "banana", "band"}));
+    REQUIRE(keys(dict.Range("c", "a")).empty());
+    REQUIRE(keys(dict.RangeFrom("bandit")) == std::vector<std::string>({"bandit", "cherry"}));
+}
+
+TEST_CASE("TrieTable") {
+    HashTable<std::string, int> source;
+    std::map<std::string, int> expected;
+    for (int i = 0; i < 500; ++i) {
+        std::string word;
+        for (int x = i * 7919 % 1000; x > 0; x /= 5) {
+            word.push_back(static_cast<char>('a' + x % 5));
+        }
+        source.Add(word, i);
+        expected[word] = i;
+    }
+    TrieTable<int> trie(source);
+    REQUIRE(trie.GetCount() == expected.size());
+
+    auto pairs = ToPairs(trie);
+    REQUIRE(pairs.size() == expected.size());
+    auto exp_it = expected.begin();
+    for (const auto& kv : pairs) {
+        REQUIRE(kv.key == exp_it->first);
+        REQUIRE(kv.value == exp_it->second);
+        REQUIRE(trie.Get(kv.key) == kv.value);
+        ++exp_it;
+    }
+    REQUIRE(trie.ContainsKey(""));
+    REQUIRE_FALSE(trie.ContainsKey("abcabcabc"));
+    REQUIRE_THROWS_AS(trie.Get("f"), std::out_of_range);
+    REQUIRE_THROWS_AS(trie.Add("x", 1), std::logic_error);
+
+    auto count = [](IIteratorPtr<KeyValue<std::string, int>> it) {
+        size_t n = 0;
+        for (; it->HasNext(); it->Next()) {
+            ++n;
+        }
+        return n;
+    };
+    auto expected_range = [&](const std::string& lo, const std::string& hi) {
+        return static_cast<size_t>(std::distance(expected.lower_bound(lo), expected.lower_bound(hi)));
+    };
+    REQUIRE(count(trie.ScanPrefix("ab")) == expected_range("ab", "ac"));
+    REQUIRE(count(trie.Range("b", "cz")) == expected_range("b", "cz"));
+    REQUIRE(count(trie.Range("bcaa", "bcab")) == expected_range("bcaa", "bcab"));
+    REQUIRE(count(trie.RangeFrom("e")) == expected_range("e", "f"));
+    REQUIRE(trie.ScanPrefix("dd")->GetCurrentItem().key.starts_with("dd"));
+
+    auto book = BuildBook<TrieTable<int>>("beta alpha beta gamma", 2, AlphabetIndexMode::Words);
+    REQUIRE(book.index->Get("beta") == 1);
+    REQUIRE(book.index->Get("alpha") == 2);
+    REQUIRE(book.index->Get("gamma") == 3);
+    REQUIRE(ToPairs(*book.index).front().key == "alpha");
+}
+
+TEST_CASE("ParallelSort") {
+    const size_t n = 50000;
+    ArraySequence<KeyValue<int, int>> items(n);
+    for (size_t i = 0; i < n; ++i) {
+        items.Set(KeyValue<int, int>(static_cast<int>(i * 2654435761u % 1000), static_cast<int>(i)), i);
+    }
+    auto expected = ToVector(items);
+    std::stable_sort(expected.begin(), expected.end(), KeyLess<int, int>());
+
+    for (size_t threads : {1, 3, 8}) {
+        ArraySequence<KeyValue<int, int>> copy(items);
+        ParallelMergeSort(copy.GetBegin(), n, KeyLess<int, int>(), threads);
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE(copy.Get(i).key == expected[i].key);
+            REQUIRE(copy.Get(i).value == expected[i].value);
+        }
+    }
+
+    SortedSequence<int> sorted(ListSequence<int>(std::vector<int>({9, 3, 7, 1}).data(), 4));
+    REQUIRE(ToVector(sorted) == std::vector<int>({1, 3, 7, 9}));
+
+    // Pool threads are reused across runs; nested runs and task errors are
+    // handled on the calling thread.
+    std::vector<std::atomic<int>> hits(64);
+    for (int round = 0; round < 100; ++round) {
+        ParallelFor(hits.size(), 4, [&](size_t task) {
+            ParallelFor(2, 2, [&](size_t) { ++hits[task]; });
+        });
+    }
+    for (const auto& hit : hits) {
+        REQUIRE(hit == 200);
+    }
+    auto failing = [](size_t task) {
+        if (task == 5) {
+            throw std::runtime_error("task");
+        }
+    };
+    REQUIRE_THROWS_AS(ParallelFor(8, 4, failing), std::runtime_error);
+}
+
+TEST_CASE("FlatBulk") {
+    HashTable<std::string, int> source;
+    for (int i = 0; i < 300; ++i) {
+        source.Add("w" + std::to_string(i), i);
+    }
+    FlatTable<std::string, int> flat(source);
+    REQUIRE(flat.GetCount() == 300);
+    REQUIRE(flat.Get("w42") == 42);
+    auto pairs = ToPairs(flat);
+    REQUIRE(std::is_sorted(pairs.begin(), pairs.end(), KeyLess<std::string, int>()));
+}
+
+TEST_CASE("RadixSort") {
+    std::vector<std::string> words = {"", "b", "\xd0\xb0", "ab"};
+    for (int i = 0; i < 40000; ++i) {
+        std::string word(static_cast<size_t>(i % 7) * 3, 'p');
+        for (int x = i * 40503 % 65536; x > 0; x /= 6) {
+            word.push_back(static_cast<char>('a' + x % 6));
+        }
+        words.push_back(word);
+    }
+    auto expected = words;
+    std::sort(expected.begin(), expected.end());
+
+    for (size_t threads : {1, 4}) {
+        auto copy = words;
+        StringRadixSort<std::string, std::less<std::string>>(copy.data(), copy.size(), threads);
+        REQUIRE(copy == expected);
+    }
+
+    // Nested prefixes split off one key per byte, so the depth of the sort
+    // reaches the length of the longest key.
+    std::vector<std::string> nested;
+    for (size_t i = 1; i <= 5000; ++i) {
+        nested.push_back(std::string(i, 'a'));
+    }
+    for (int i = 0; i < 20000; ++i) {
+        nested.push_back("b" + std::to_string(i));
+    }
+    std::reverse(nested.begin(), nested.end());
+    auto nested_expected = nested;
+    std::sort(nested_expected.begin(), nested_expected.end());
+    for (size_t threads : {1, 4}) {
+        auto copy = nested;
+        StringRadixSort<std::string, std::less<std::string>>(copy.data(), copy.size(), threads);
+        REQUIRE(copy == nested_expected);
+    }
+
+    ArraySequence<KeyValue<std::string, int>> pairs;
+    for (int i = 0; i < 100; ++i) {
+        pairs.Append(KeyValue<std::string, int>(i % 2 == 0 ? "even" : "odd", i));
+    }
+    SortedSequence<KeyValue<std::string, int>, KeyLess<std::string, int>> sorted(std::move(pairs));
+    for (size_t i = 0; i < sorted.GetLength(); ++i) {
+        int expected_value = i < 50 ? static_cast<int>(2 * i) : static_cast<int>(2 * (i - 50) + 1);
+        REQUIRE(sorted.Get(i).value == expected_value);
+    }
+}
+
+TEST_CASE("SmallSeq") {
+    SmallSequence<std::string, 2> seq;
+    seq.Append("b");
+    seq.Prepend("a");
+    REQUIRE(seq.IsInline());
+    REQUIRE(seq.GetCapacity() == 2);
+
+    seq.Append("d");
+    seq.InsertAt("c", 2);
+    REQUIRE_FALSE(seq.IsInline());
+    REQUIRE(ToVector(seq) == std::vector<std::string>({"a", "b", "c", "d"}));
+
+    seq.EraseAt(1);
+    REQUIRE(ToVector(seq) == std::vector<std::string>({"a", "c", "d"}));
+    REQUIRE(ToVector(seq.GetLast(2)) == std::vector<std::string>({"c", "d"}));
+    REQUIRE_THROWS_AS(seq.Get(3), std::out_of_range);
+
+    SmallSequence<std::string, 2> moved(std::move(seq));
+    REQUIRE(moved.GetLength() == 3);
+    REQUIRE(seq.GetLength() == 0);
+    REQUIRE(seq.IsInline());
+
+    SmallSequence<std::string, 2> small;
+    small.Append("x");
+    SmallSequence<std::string, 2> copy = small;
+    copy.Set("y", 0);
+    REQUIRE(copy.IsInline());
+    REQUIRE(small.Get(0) == "x");
+    REQUIRE(copy.Get(0) == "y");
+}
+
+TEST_CASE("Arena") {
+    struct CountingResource : std::pmr::memory_resource {
+        size_t allocations = 0;
+
+        void* do_allocate(size_t bytes, size_t align) override {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    std::string text = "the quick brown fox jumps over the lazy dog and the quick cat";
+    std::ostringstream expected;
+    WriteBook(BuildBook<FlatTable<std::string, int>>(text, 4, AlphabetIndexMode::Words), expected);
+
+    CountingResource counting;
+    {
+        auto book = BuildBook<FlatTable<std::string, int>>(text, 4, AlphabetIndexMode::Words, 0, &counting);
+        std::ostringstream out;
+        WriteBook(book, out);
+        REQUIRE(out.str() == expected.str());
+    }
+    REQUIRE(counting.allocations > 0);
+
+    SequencePtr<Page> pages;
+    {
+        auto book = BuildBookInArena<HashTable<std::string, int>>(text, 4, AlphabetIndexMode::Words);
+        REQUIRE(book.arena != nullptr);
+        REQUIRE(book.index->Get("lazy") == book.index->Get("dog"));
+        pages = book.pages;
+    }
+    REQUIRE(pages->GetLength() > 0);
+    REQUIRE(pages->GetFirst().number == 1);
+}
+
+TEST_CASE("Stats") {
+    HashTable<std::string, int> hash;
+    FlatTable<std::string, int> flat;
+    for (int i = 0; i < 100; ++i) {
+        hash.Add(std::to_string(i), i);
+        flat.Add(std::to_string(i), i);
+    }
+    hash.ResetStats();
+    flat.ResetStats();
+    REQUIRE(hash.ContainsKey("42"));
+    REQUIRE(flat.Get("42") == 42);
+
+    auto hash_stats = hash.GetStats();
+    uint64_t buckets = 0;
+    for (auto count : hash_stats.chain_lengths) {
+        buckets += count;
+    }
+    REQUIRE(buckets == hash.GetCapacity());
+
+    auto flat_stats = flat.GetStats();
+    auto book = BuildBook<HashTable<std::string, int>>("one two three two", 4, AlphabetIndexMode::Words);
+    if constexpr (kStatsEnabled) {
+        REQUIRE(hash_stats.lookup.lookups == 1);
+        REQUIRE(hash_stats.lookup.comparisons >= 1);
+        REQUIRE(hash_stats.rehashes == 0);
+        REQUIRE(flat_stats.lookups == 1);
+        REQUIRE(flat_stats.comparisons <= 8);
+        REQUIRE(book.stats.lexer.items == 4);
+        REQUIRE(book.stats.lexer.bytes == 14);
+        REQUIRE(book.stats.lines.items == 4);
+        REQUIRE(book.stats.pages.bytes == 14);
+    } else {
+        REQUIRE(hash_stats.lookup.lookups == 0);
+        REQUIRE(flat_stats.comparisons == 0);
+        REQUIRE(book.stats.lexer.items == 0);
+    }
+
+    std::ostringstream out;
+    WriteJson(out, book.stats);
+    REQUIRE(out.str().rfind("{\"lexer\":{\"items\":", 0) == 0);
+}
+
+TEST_CASE("Corpus") {
+    auto split = [](const std::string& text) {
+        std::vector<std::string> words;
+        std::istringstream in(text);
+        for (std::string w; in >> w;) {
+            words.push_back(w);
+        }
+        return words;
+    };
+
+    CorpusOptions options;
+    options.vocabulary = 500;
+    std::string text = GenerateCorpus(20000, options);
+    REQUIRE(text == GenerateCorpus(20000, options));
+    options.seed = 2;
+    REQUIRE(text != GenerateCorpus(20000, options));
+
+    auto words = split(text);
+    REQUIRE(words.size() == 20000);
+    std::unordered_map<std::string, size_t> freq;
+    for (const auto& w : words) {
+        ++freq[w];
+    }
+    REQUIRE(freq.size() <= 500);
+    size_t top = 0;
+    for (const auto& [w, n] : freq) {
+        top = std::max(top, n);
+    }
+    // Rank 1 of Zipf(1) over 500 words takes about 15% of the draws.
+    REQUIRE(top > 2000);
+
+    options.kind = CorpusKind::Collide;
+    options.vocabulary = 20;
+    std::unordered_set<size_t> buckets;
+    for (const auto& w : split(GenerateCorpus(1000, options))) {
+        buckets.insert(std::hash<std::string>()(w) % kCollisionModulus);
+    }
+    REQUIRE(buckets.size() == 1);
+    // Too few colliding words of two letters: longer ones are allowed.
+    options.max_length = 2;
+    options.vocabulary = 100;
+    std::unordered_set<std::string> distinct;
+    buckets.clear();
+    for (const auto& w : split(GenerateCorpus(5000, options))) {
+        distinct.insert(w);
+        buckets.insert(std::hash<std::string>()(w) % kCollisionModulus);
+    }
+    REQUIRE(distinct.size() > 50);
+    REQUIRE(buckets.size() == 1);
+    options.max_length = 16;
+
+    options.kind = CorpusKind::Prefix;
+    auto prefixed = split(GenerateCorpus(1000, options));
+    for (const auto& w : prefixed) {
+        REQUIRE(w.compare(0, kSharedPrefixLength, prefixed[0], 0, kSharedPrefixLength) == 0);
+    }
+
+    options.kind = CorpusKind::Cyclic;
+    options.max_length = 3;
+    REQUIRE(GenerateCorpus(4, options) == "a bc cde d ");
+}
+
+TEST_CASE("BufferedWriter") {
+    std::ostringstream expected;
+    for (int i = -50; i < 2000; ++i) {
+        expected << "word" << i << ' ' << static_cast<size_t>(i * i) << std::string((i + 50) % 37, 'x') << '\n';
+    }
+    for (bool async : {false, true}) {
+        std::ostringstream out;
+        {
+            BufferedWriter writer(out, 7, async);
+            for (int i = -50; i < 2000; ++i) {
+                writer << "word" << i << ' ' << static_cast<size_t>(i * i) << std::string((i + 50) % 37, 'x') << '\n';
+            }
+        }
+        REQUIRE(out.str() == expected.str());
+    }
+
+    std::string text = "alpha beta gamma alpha delta";
+    auto book = BuildConcordanceBook<FlatTable<std::string, int>, HashTable<std::string, PostingListPtr>>(
+        text, 3, AlphabetIndexMode::Words, 0, ConcordanceOptions{.with_lines = true, .keys = {}});
+    std::ostringstream buffered;
+    WriteBook(book, buffered);
+    std::ostringstream concordance;
+    for (auto it = book.concordance->GetSortedIterator(); it->HasNext(); it->Next()) {
+        concordance << it->GetCurrentItem().key << " -> " << *it->GetCurrentItem().value << '\n';
+    }
+    REQUIRE(buffered.str().find("Index:\nalpha -> 1\nbeta -> 2\ndelta -> 3\ngamma -> 2\n") != std::string::npos);
+    REQUIRE(buffered.str().ends_with(concordance.str()));
+}
+
+TEST_CASE("SortedExport") {
+    HashTable<std::string, int> hash;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 3000; ++i) {
+        keys.push_back("k" + std::to_string(i * 7919 % 3001));
+        hash.Add(keys.back(), i);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<std::string> sorted;
+    for (auto it = hash.GetSortedIterator(); it->HasNext(); it->Next()) {
+        const auto& kv = it->GetCurrentItem();
+        REQUIRE(hash.Get(kv.key) == kv.value);
+        sorted.push_back(kv.key);
+    }
+    REQUIRE(sorted == keys);
+
+    HashTable<int, int> ints;
+    for (int i = 10; i > 0; --i) {
+        ints.Add(i * 37 % 11, i);
+    }
+    int prev = -1;
+    for (auto it = ints.GetSortedIterator(); it->HasNext(); it->Next()) {
+        REQUIRE(it->GetCurrentItem().key > prev);
+        prev = it->GetCurrentItem().key;
+    }
+    REQUIRE_FALSE(HashTable<int, int>().GetSortedIterator()->HasNext());
+
+    auto book = BuildBook<HashTable<std::string, int>>("delta alpha charlie bravo", 100, AlphabetIndexMode::Words);
+    std::ostringstream out;
+    WriteBook(book, out);
+    REQUIRE(out.str().ends_with("Index:\nalpha -> 1\nbravo -> 1\ncharlie -> 1\ndelta -> 1\n"));
+}
+
+TEST_CASE("Reserve") {
+    ArraySequence<int> seq;
+    seq.Append(1);
+    seq.Reserve(100);
+    REQUIRE(seq.GetCapacity() == 100);
+    REQUIRE(seq.GetLength() == 1);
+    REQUIRE(seq.GetFirst() == 1);
+    seq.Reserve(10);
+    REQUIRE(seq.GetCapacity() == 100);
+
+    HashTable<std::string, int> hash;
+    hash.Add("x", 0);
+    hash.Reserve(1000);
+    size_t capacity = hash.GetCapacity();
+    REQUIRE(capacity * 3 > 1000 * 4);
+    for (int i = 0; i < 999; ++i) {
+        hash.Add(std::to_string(i), i);
+    }
+    REQUIRE(hash.GetCapacity() == capacity);
+    REQUIRE(hash.Get("x") == 0);
+    REQUIRE(hash.Get("998") == 998);
+
+    CorpusOptions options;
+    options.vocabulary = 3000;
+    std::string text = GenerateCorpus(50000, options);
+    std::unordered_set<std::string> distinct;
+    std::istringstream in(text);
+    for (std::string w; in >> w;) {
+        distinct.insert(w);
+    }
+    auto estimate = EstimateText(text);
+    REQUIRE(estimate.words == 50000);
+    REQUIRE(estimate.distinct > distinct.size() * 9 / 10);
+    REQUIRE(estimate.distinct < distinct.size() * 11 / 10);
+    REQUIRE(EstimateText("").distinct == 0);
+    REQUIRE(EstimateText("  a b a  ").distinct == 2);
+}
+
+TEST_CASE("StaticPipeline") {
+    std::string text = "lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor";
+    for (auto mode : {AlphabetIndexMode::Words, AlphabetIndexMode::Chars}) {
+        StringCharStream chars(text);
+        LexerStream lexer(chars);
+        LineRenderer lines(lexer, DefaultLineSize(12, mode), mode);
+        PaginatorStream paginator(lines, 12, mode);
+        std::vector<std::vector<std::string>> dynamic;
+        for (Page page; paginator.Read(page);) {
+            dynamic.emplace_back();
+            for (auto lit = page.lines->GetIterator(); lit->HasNext(); lit->Next()) {
+                auto words = ToVector(*lit->GetCurrentItem().words);
+                dynamic.back().insert(dynamic.back().end(), words.begin(), words.end());
+            }
+        }
+
+        std::vector<std::vector<std::string>> fixed;
+        Paginate(text, 12, mode, 0, [&](const std::string& word, int page, int) {
+            fixed.resize(page);
+            fixed[page - 1].push_back(word);
+        });
+        REQUIRE(fixed == dynamic);
+        REQUIRE(dynamic.size() > 1);
+    }
+}
+
+TEST_CASE("Utf8Lexer") {
+    // NBSP, em space and ideographic space separate words; \xff is malformed and stays in its word.
+    std::string text = "  Привет,\xc2\xa0мир!\te\xcc\x81t\xc3\xa9\xe2\x80\x83\xff"
+                       "bad \xe3\x80\x80 \xe2\x80\x94 \xd0\x81LKA long_word_crossing_a_sixteen_byte_block  ";
+    std::vector<std::string> expected = {
+        "Привет,", "мир!", "e\xcc\x81t\xc3\xa9", "\xff" "bad", "\xe2\x80\x94", "\xd0\x81LKA",
+        "long_word_crossing_a_sixteen_byte_block"};
+
+    StringCharStream in_place(text);
+    BasicLexerStream<StringCharStream> fast(in_place);
+    StringCharStream by_char(text);
+    LexerStream slow(by_char);
+    std::vector<std::string> fast_words;
+    std::vector<std::string> slow_words;
+    for (std::string w; fast.Read(w);) {
+        fast_words.push_back(w);
+    }
+    for (std::string w; slow.Read(w);) {
+        slow_words.push_back(w);
+    }
+    REQUIRE(fast_words == expected);
+    REQUIRE(slow_words == expected);
+    REQUIRE(EstimateText(text).words == expected.size());
+
+    KeyOptions keys{true, true};
+    REQUIRE(NormalizeKey("Привет,", keys) == "привет");
+    REQUIRE(NormalizeKey("«Ёлка»", keys) == "ёлка");
+    REQUIRE(NormalizeKey("(Don't)", keys) == "don't");
+    REQUIRE(NormalizeKey("ÀÉ\xff", keys) == "àé\xff");
+    REQUIRE(NormalizeKey("\xe2\x80\x94", keys).empty());
+    REQUIRE(NormalizeKey("Word.", KeyOptions{false, true}) == "word.");
+
+    auto book = BuildBook<HashTable<std::string, int>>("Мир, мир. Мир! — конец", 2, AlphabetIndexMode::Words, 0,
+                                                       DefaultResource(), keys);
+    REQUIRE(book.index->GetCount() == 2);
+    REQUIRE(book.index->Get("мир") == 1);
+    REQUIRE(book.index->Get("конец") == 3);
+}
+
+TEST_CASE("CollisionResilience") {
+    // Every key has the same hash: growing the table cannot split the chain.
+    struct ConstantHash {
+        size_t operator()(const std::string&) const {
+            return 42;
+        }
+    };
+    HashTable<std::string, int, ConstantHash> table;
+    const int count = 4096;
+    for (int i = 0; i < count; ++i) {
+        table.Add("key" + std::to_string(i * 7919 % count), i);
+    }
+    REQUIRE(table.GetCount() == count);
+    REQUIRE(table.GetCapacity() < 4 * count);
+    for (int i = 0; i < count; ++i) {
+        REQUIRE(table.Get("key" + std::to_string(i * 7919 % count)) == i);
+    }
+    REQUIRE_FALSE(table.ContainsKey("key" + std::to_string(count)));
+
+    table.ResetStats();
+    for (int i = 0; i < count; ++i) {
+        table.ContainsKey("key" + std::to_string(i));
+    }
+    if constexpr (kStatsEnabled) {
+        // Bisection over the chain: about log2(count) comparisons per lookup.
+        REQUIRE(table.GetStats().lookup.comparisons < count * 16);
+    }
+
+    for (int i = 0; i < count; i += 2) {
+        table.Remove("key" + std::to_string(i));
+    }
+    REQUIRE(table.GetCount() == count / 2);
+    std::vector<std::string> keys;
+    for (auto it = table.GetSortedIterator(); it->HasNext(); it->Next()) {
+        keys.push_back(it->GetCurrentItem().key);
+        REQUIRE(table.ContainsKey(keys.back()));
+    }
+    REQUIRE(keys.size() == count / 2);
+
+    // Hashes that only collide modulo the capacity are spread by the mixing step.
+    struct StrideHash {
+        size_t operator()(int key) const {
+            return static_cast<size_t>(key) << 20;
+        }
+    };
+    HashTable<int, int, StrideHash> strided;
+    for (int i = 0; i < count; ++i) {
+        strided.Add(i, i);
+    }
+    REQUIRE(strided.GetCapacity() < 4 * count);
+    REQUIRE(strided.GetStats().chain_lengths[kChainHistogramSize - 1] == 0);
+
+    // Keys that are not totally ordered keep linear chains, but the table
+    // stops growing for them as well.
+    struct PartialKey {
+        int id;
+        bool operator==(const PartialKey&) const = default;
+        bool operator<(const PartialKey& other) const {
+            return id < other.id;
+        }
+    };
+    struct PartialHash {
+        size_t operator()(const PartialKey&) const {
+            return 7;
+        }
+    };
+    HashTable<PartialKey, int, PartialHash> partial;
+    for (int i = 0; i < 1000; ++i) {
+        partial.Add(PartialKey{i}, i);
+    }
+    REQUIRE(partial.GetCapacity() < 4 * 1000);
+    REQUIRE(partial.Get(PartialKey{999}) == 999);
+}
+
+TEST_CASE("HashShrink") {
+    HashTable<int, int> table;
+    const size_t empty_capacity = table.GetCapacity();
+    const int count = 10000;
+    for (int i = 0; i < count; ++i) {
+        table.Add(i, i);
+    }
+    const size_t full_capacity = table.GetCapacity();
+    for (int i = 0; i < count - 10; ++i) {
+        table.Remove(i);
+    }
+    REQUIRE(table.GetCapacity() < full_capacity / 16);
+    std::vector<int> left;
+    for (auto it = table.GetIterator(); it->HasNext(); it->Next()) {
+        left.push_back(it->GetCurrentItem().key);
+    }
+    std::sort(left.begin(), left.end());
+    REQUIRE(left == std::vector<int>{9990, 9991, 9992, 9993, 9994, 9995, 9996, 9997, 9998, 9999});
+
+    // Hysteresis: hovering around a boundary does not rehash every time.
+    size_t capacity = table.GetCapacity();
+    for (int round = 0; round < 100; ++round) {
+        table.Add(-1, 0);
+        table.Remove(-1);
+    }
+    REQUIRE(table.GetCapacity() == capacity);
+
+    // Reserved capacity is kept until ShrinkToFit.
+    table.Reserve(5000);
+    size_t reserved = table.GetCapacity();
+    for (int i = 9990; i < 10000; ++i) {
+        table.Remove(i);
+    }
+    REQUIRE(table.GetCapacity() == reserved);
+    REQUIRE_FALSE(table.GetIterator()->HasNext());
+    table.ShrinkToFit();
+    REQUIRE(table.GetCapacity() == empty_capacity);
+
+    table.Add(7, 7);
+    REQUIRE(table.Get(7) == 7);
+    REQUIRE(table.GetCount() == 1);
+}
+
+TEST_CASE("PerfectHash") {
+    HashTable<std::string, int> source;
+    const int count = 20000;
+    for (int i = 0; i < count; ++i) {
+        source.Add("w" + std::to_string(i * 31), i);
+    }
+    auto frozen = Freeze(source);
+    REQUIRE(frozen->GetCount() == count);
+    for (int i = 0; i < count; ++i) {
+        REQUIRE(frozen->Get("w" + std::to_string(i * 31)) == i);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE_FALSE(frozen->ContainsKey("w" + std::to_string(i * 31 + 1)));
+    }
+    REQUIRE_THROWS_AS(frozen->Get("missing"), std::out_of_range);
+    REQUIRE_THROWS_AS(frozen->Add("x", 1), std::logic_error);
+
+    std::vector<std::string> sorted;
+    for (auto it = frozen->GetSortedIterator(); it->HasNext(); it->Next()) {
+        sorted.push_back(it->GetCurrentItem().key);
+    }
+    REQUIRE(sorted.size() == count);
+    REQUIRE(std::is_sorted(sorted.begin(), sorted.end()));
+
+    std::stringstream image;
+    REQUIRE(frozen->Serialize(image));
+    auto loaded = PerfectHashTable<int>::Deserialize(image);
+    REQUIRE(loaded != nullptr);
+    REQUIRE(loaded->GetCount() == count);
+    REQUIRE(loaded->Get("w310") == 10);
+    REQUIRE_FALSE(loaded->ContainsKey("w311"));
+
+    std::string truncated = image.str().substr(0, image.str().size() / 2);
+    std::istringstream bad(truncated);
+    REQUIRE(PerfectHashTable<int>::Deserialize(bad) == nullptr);
+
+    // Frozen from another frozen backend, and built directly by BuildBook.
+    auto refrozen = Freeze(*loaded);
+    REQUIRE(refrozen->Get("w620") == 20);
+    HashTable<std::string, int> empty;
+    REQUIRE(Freeze(empty)->GetCount() == 0);
+    REQUIRE_FALSE(Freeze(empty)->ContainsKey(""));
+
+    auto book = BuildBook<PerfectHashTable<int>>("beta alpha beta gamma", 2, AlphabetIndexMode::Words);
+    REQUIRE(book.index->Get("beta") == 1);
+    REQUIRE(book.index->Get("gamma") == 3);
+}
+
+TEST_CASE("BloomFilter") {
+    const size_t count = 20000;
+    BlockedBloomFilter filter(count);
+    for (size_t i = 0; i < count; ++i) {
+        filter.Add(MixHash(i));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        REQUIRE(filter.MayContain(MixHash(i)));
+    }
+    size_t false_positives = 0;
+    for (size_t i = count; i < 2 * count; ++i) {
+        false_positives += filter.MayContain(MixHash(i)) ? 1 : 0;
+    }
+    REQUIRE(false_positives < count / 25);
+
+    auto inner = std::make_shared<HashTable<std::string, int>>();
+    inner->Add("alpha", 1);
+    inner->Add("beta", 2);
+    FilteredDictionary<std::string, int> dict(inner);
+    REQUIRE(dict.Get("alpha") == 1);
+    REQUIRE_FALSE(dict.ContainsKey("gamma"));
+    REQUIRE_THROWS_AS(dict.Get("gamma"), std::out_of_range);
+    for (int i = 0; i < 1000; ++i) {
+        dict.Add("k" + std::to_string(i), i);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(dict.Get("k" + std::to_string(i)) == i);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        dict.Remove("k" + std::to_string(i));
+    }
+    REQUIRE(dict.GetCount() == 2);
+    REQUIRE_FALSE(dict.ContainsKey("k1"));
+    REQUIRE(dict.ContainsKey("beta"));
+
+    dict.ResetStats();
+    for (int i = 0; i < 1000; ++i) {
+        dict.ContainsKey("missing" + std::to_string(i));
+        // A miss through Get counts the same way.
+        REQUIRE_THROWS_AS(dict.Get("absent" + std::to_string(i)), std::out_of_range);
+    }
+    if constexpr (kStatsEnabled) {
+        auto stats = dict.GetStats();
+        REQUIRE(stats.queries == 2000);
+        REQUIRE(stats.rejected + stats.false_positives == 2000);
+        REQUIRE(stats.rejected > 1800);
+    }
+}
+
+TEST_CASE("BPlusTree") {
+    BPlusTree<std::string, int> tree;
+    std::map<std::string, int> expected;
+    SplitMix64 rng(7);
+    for (int i = 0; i < 5000; ++i) {
+        std::string key = "k" + std::to_string(rng.Next() % 3000);
+        tree.Add(key, i);
+        expected[key] = i;
+    }
+    REQUIRE(tree.GetCount() == expected.size());
+    REQUIRE(tree.GetHeight() > 2);
+    for (const auto& [key, value] : expected) {
+        REQUIRE(tree.Get(key) == value);
+    }
+    REQUIRE_FALSE(tree.ContainsKey("k"));
+    REQUIRE_THROWS_AS(tree.Get("zzz"), std::out_of_range);
+
+    std::vector<std::pair<std::string, int>> walked;
+    for (auto it = tree.GetIterator(); it->HasNext(); it->Next()) {
+        walked.emplace_back(it->GetCurrentItem().key, it->GetCurrentItem().value);
+    }
+    REQUIRE(walked == std::vector<std::pair<std::string, int>>(expected.begin(), expected.end()));
+
+    size_t in_range = 0;
+    for (auto it = tree.Range("k1", "k2"); it->HasNext(); it->Next()) {
+        REQUIRE(it->GetCurrentItem().key >= "k1");
+        REQUIRE(it->GetCurrentItem().key < "k2");
+        ++in_range;
+    }
+    REQUIRE(in_range == static_cast<size_t>(std::distance(expected.lower_bound("k1"), expected.lower_bound("k2"))));
+    REQUIRE(tree.ScanPrefix("k29")->GetCurrentItem().key == expected.lower_bound("k29")->first);
+
+    // Remove most keys, then everything.
+    size_t removed = 0;
+    for (auto it = expected.begin(); it != expected.end();) {
+        if (removed++ % 4 != 0) {
+            tree.Remove(it->first);
+            it = expected.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    REQUIRE_THROWS_AS(tree.Remove("k"), std::out_of_range);
+    REQUIRE(tree.GetCount() == expected.size());
+    walked.clear();
+    for (auto it = tree.GetIterator(); it->HasNext(); it->Next()) {
+        walked.emplace_back(it->GetCurrentItem().key, it->GetCurrentItem().value);
+    }
+    REQUIRE(walked == std::vector<std::pair<std::string, int>>(expected.begin(), expected.end()));
+    for (const auto& [key, value] : expected) {
+        tree.Remove(key);
+    }
+    REQUIRE(tree.GetCount() == 0);
+    REQUIRE_FALSE(tree.GetIterator()->HasNext());
+    tree.Add("again", 1);
+    REQUIRE(tree.Get("again") == 1);
+
+    // Bulk load from an unordered source.
+    HashTable<std::string, int> source;
+    for (int i = 0; i < 1000; ++i) {
+        source.Add("b" + std::to_string(i), i);
+    }
+    BPlusTree<std::string, int> loaded(source);
+    REQUIRE(loaded.GetCount() == 1000);
+    std::string prev;
+    for (auto it = loaded.GetIterator(); it->HasNext(); it->Next()) {
+        REQUIRE(prev < it->GetCurrentItem().key);
+        prev = it->GetCurrentItem().key;
+    }
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(loaded.Get("b" + std::to_string(i)) == i);
+    }
+    loaded.Add("b5000", 5000);
+    REQUIRE(loaded.Get("b5000") == 5000);
+
+    auto book = BuildBook<BPlusTree<std::string, int>>("beta alpha beta gamma", 2, AlphabetIndexMode::Words);
+    REQUIRE(book.index->GetSortedIterator()->GetCurrentItem().key == "alpha");
+    REQUIRE(book.index->Get("gamma") == 3);
+}
+
+TEST_CASE("FlatTableLayout") {
+    // Keys sharing their first eight bytes fall back to full comparisons.
+    FlatTable<std::string, int> dict;
+    std::map<std::string, int> expected;
+    SplitMix64 rng(3);
+    for (int i = 0; i < 2000; ++i) {
+        std::string key = (rng.Next() % 2 ? "prefix__" : "pre") + std::to_string(rng.Next() % 500);
+        if (rng.Next() % 5 == 0) {
+            key += std::string(1, '\0');
+        }
+        dict.Add(key, i);
+        expected[key] = i;
+    }
+    size_t visited = 0;
+    for (auto it = expected.begin(); it != expected.end();) {
+        if (visited++ % 3 == 0) {
+            dict.Remove(it->first);
+            it = expected.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    REQUIRE(dict.GetCount() == expected.size());
+    auto it = dict.GetIterator();
+    for (const auto& [key, value] : expected) {
+        REQUIRE(it->GetCurrentItem().key == key);
+        REQUIRE(it->GetCurrentItem().value == value);
+        REQUIRE(dict.Get(key) == value);
+        it->Next();
+    }
+    REQUIRE_FALSE(it->HasNext());
+    REQUIRE_FALSE(dict.ContainsKey("prefix__"));
+    REQUIRE(ToVector(dict.GetKeys()).size() == expected.size());
+
+    FlatTable<std::string, int> built(dict);
+    REQUIRE(built.GetCount() == dict.GetCount());
+    REQUIRE(built.GetIterator()->GetCurrentItem().key == expected.begin()->first);
+    REQUIRE(built.Get(expected.rbegin()->first) == expected.rbegin()->second);
+}
+
+TEST_CASE("SequenceViews") {
+    HashTable<std::string, int> hash;
+    FlatTable<std::string, int> flat;
+    for (int i = 0; i < 50; ++i) {
+        hash.Add("k" + std::to_string(i), i);
+        flat.Add("k" + std::to_string(i), i);
+    }
+
+    auto keys = hash.GetKeys();
+    auto values = hash.GetValues();
+    REQUIRE(keys->GetLength() == 50);
+    size_t i = 0;
+    for (auto it = hash.GetIterator(); it->HasNext(); it->Next(), ++i) {
+        REQUIRE(keys->Get(i) == it->GetCurrentItem().key);
+        REQUIRE(values->Get(i) == it->GetCurrentItem().value);
+    }
+    REQUIRE(keys->GetFirst() == keys->Get(0));
+    REQUIRE(keys->GetLast() == keys->Get(49));
+    auto middle = keys->GetSubsequence(3, 5);
+    REQUIRE(ToVector(middle) == std::vector<std::string>({keys->Get(3), keys->Get(4), keys->Get(5)}));
+    REQUIRE_THROWS_AS(keys->Get(50), std::out_of_range);
+    REQUIRE_THROWS_AS(keys->Append("x"), std::logic_error);
+
+    auto owned = Materialize(keys);
+    REQUIRE(owned != keys);
+    REQUIRE(ToVector(owned) == ToVector(keys));
+    hash.Add("extra", 1);
+    REQUIRE(hash.GetKeys()->GetLength() == 51);
+    REQUIRE(owned->GetLength() == 50);
+    owned->Append("x");
+    REQUIRE(Materialize(owned) == owned);
+
+    auto flat_keys = flat.GetKeys();
+    REQUIRE(flat_keys->GetLength() == 50);
+    REQUIRE(flat_keys->GetFirst() == "k0");
+    REQUIRE(ToVector(flat.GetValues()).size() == 50);
+    REQUIRE(ToVector(flat_keys->GetLast(2)) == std::vector<std::string>({"k8", "k9"}));
+    REQUIRE(flat_keys->GetFirst(0)->GetLength() == 0);
+
+    BPlusTree<std::string, int> tree(flat);
+    REQUIRE(ToVector(tree.GetKeys()) == ToVector(flat_keys));
+
+    // Flat views are snapshots: later writes copy the table's arrays instead.
+    auto flat_values = flat.GetValues();
+    flat.Add("a", -1);
+    flat.Remove("k0");
+    REQUIRE(flat_keys->GetLength() == 50);
+    REQUIRE(flat_keys->Get(0) == "k0");
+    REQUIRE(flat_values->Get(0) == 0);
+    REQUIRE(flat.GetKeys()->Get(0) == "a");
+
+    // Views keep a dictionary held by shared_ptr alive.
+    auto shared = std::make_shared<HashTable<std::string, int>>();
+    shared->Add("only", 7);
+    auto shared_keys = shared->GetKeys();
+    auto shared_values = shared->GetValues();
+    shared.reset();
+    REQUIRE(shared_keys->Get(0) == "only");
+    REQUIRE(shared_values->Get(0) == 7);
+
+    // So do their iterators, even once the view itself is gone.
+    auto shared_flat = std::make_shared<FlatTable<std::string, int>>(flat);
+    auto flat_it = shared_flat->GetKeys()->GetIterator();
+    shared_flat.reset();
+    std::vector<std::string> iterated;
+    for (; flat_it->HasNext(); flat_it->Next()) {
+        iterated.push_back(flat_it->GetCurrentItem());
+    }
+    REQUIRE(iterated == ToVector(flat.GetKeys()));
+
+    // Frozen backends build their entries while iterating, so their keys
+    // are copied and every element keeps its own address.
+    auto frozen = Freeze(flat);
+    auto frozen_keys = frozen->GetKeys();
+    auto frozen_values = frozen->GetValues();
+    frozen.reset();
+    REQUIRE(frozen_keys->GetLength() == 50);
+    const std::string& second = frozen_keys->Get(1);
+    REQUIRE(frozen_keys->Get(5) != frozen_keys->Get(2));
+    REQUIRE(second == frozen_keys->Get(1));
+    REQUIRE(flat.Get(frozen_keys->Get(7)) == frozen_values->Get(7));
+    auto frozen_it = Freeze(flat)->GetValues()->GetIterator();
+    REQUIRE(frozen_it->GetCurrentItem() == frozen_values->Get(0));
+    auto trie_keys = TrieTable<int>(flat).GetKeys();
+    REQUIRE(ToVector(trie_keys) == ToVector(flat.GetKeys()));
+    REQUIRE(trie_keys->Get(0) != trie_keys->Get(1));
+}
+
+TEST_CASE("SequenceSlices") {
+    int items[] = {1, 2, 3, 4, 5};
+    auto seq = std::make_shared<ArraySequence<int>>(items, 5);
+
+    auto sub = std::dynamic_pointer_cast<ArraySequence<int>>(seq->GetSubsequence(1, 3));
+    REQUIRE(std::as_const(*sub).GetBegin() == std::as_const(*seq).GetBegin() + 1);
+    REQUIRE(ToVector(*sub) == std::vector<int>({2, 3, 4}));
+
+    // Writes on either side copy the shared buffer first.
+    seq->Set(30, 2);
+    REQUIRE(ToVector(*sub) == std::vector<int>({2, 3, 4}));
+    sub->Set(20, 0);
+    sub->Append(6);
+    REQUIRE(ToVector(*sub) == std::vector<int>({20, 3, 4, 6}));
+    REQUIRE(ToVector(*seq) == std::vector<int>({1, 2, 30, 4, 5}));
+
+    auto last = seq->GetLast(2);
+    seq.reset();
+    REQUIRE(ToVector(last) == std::vector<int>({4, 5}));
+    last->Prepend(0);
+    REQUIRE(ToVector(last) == std::vector<int>({0, 4, 5}));
+
+    SortedSequence<int> sorted(items, 5);
+    auto range = sorted.GetSubsequence(1, 3);
+    REQUIRE(&range->Get(0) == &sorted.Get(1));
+    REQUIRE(range->LowerBound(4) == 2);
+    range->Add(0);
+    REQUIRE(ToVector(*range) == std::vector<int>({0, 2, 3, 4}));
+    REQUIRE(sorted.GetLength() == 5);
+    REQUIRE(sorted.Get(1) == 2);
+    REQUIRE_THROWS_AS(sorted.GetSubsequence(2, 5), std::out_of_range);
+}
+
+TEST_CASE("GapBuffer") {
+    GapBufferSequence<std::string> seq;
+    std::vector<std::string> expected;
+    SplitMix64 rng(11);
+    for (int i = 0; i < 2000; ++i) {
+        size_t op = rng.Next() % 4;
+        size_t pos = expected.empty() ? 0 : rng.Next() % expected.size();
+        if (op == 0 && !expected.empty()) {
+            seq.EraseAt(pos);
+            expected.erase(expected.begin() + pos);
+        } else if (op == 1 && !expected.empty()) {
+            seq.Set("s" + std::to_string(i), pos);
+            expected[pos] = "s" + std::to_string(i);
+        } else {
+            // Clustered inserts move the gap only a little.
+            pos = std::min(expected.size(), pos % 8 + expected.size() / 2);
+            seq.InsertAt(std::to_string(i), pos);
+            expected.insert(expected.begin() + pos, std::to_string(i));
+        }
+    }
+    REQUIRE(seq.GetLength() == expected.size());
+    REQUIRE(ToVector(seq) == expected);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        REQUIRE(seq.Get(i) == expected[i]);
+    }
+    auto middle = seq.GetSubsequence(10, 19);
+    REQUIRE(ToVector(middle) == std::vector<std::string>(expected.begin() + 10, expected.begin() + 20));
+    REQUIRE(seq.GetBegin()[5] == expected[5]);
+    seq.Prepend("first");
+    REQUIRE(seq.GetFirst() == "first");
+    REQUIRE_THROWS_AS(seq.Get(seq.GetLength()), std::out_of_range);
+
+    // Nearly sorted input into a sorted sequence backed by a gap buffer.
+    SortedSequence<int, std::less<int>, GapBufferSequence<int>> sorted;
+    std::vector<int> values;
+    for (int i = 0; i < 1000; ++i) {
+        int value = i % 2 == 0 ? i : 1000 - i;
+        sorted.Add(value);
+        values.push_back(value);
+    }
+    std::sort(values.begin(), values.end());
+    REQUIRE(ToVector(sorted) == values);
+    auto lower = std::lower_bound(values.begin(), values.end(), 500);
+    REQUIRE(sorted.LowerBound(500) == static_cast<size_t>(lower - values.begin()));
+    REQUIRE(ToVector(*sorted.GetSubsequence(1, 3)) == std::vector<int>(values.begin() + 1, values.begin() + 4));
+
+    ArraySequence<std::string> array;
+    for (int i = 0; i < 100; ++i) {
+        array.InsertAt(std::to_string(i), static_cast<size_t>(i) / 2);
+    }
+    array.EraseAt(0);
+    REQUIRE(array.GetLength() == 99);
+    REQUIRE(array.Get(98) == "0");
+}
+
+TEST_CASE("UncheckedAccess") {
+    ArraySequence<int> array;
+    SmallSequence<int, 4> small;
+    DynamicArray<int> dynamic(10);
+    for (int i = 0; i < 10; ++i) {
+        array.Append(i * 3);
+        small.Append(i * 3);
+        dynamic.Set(i * 3, i);
+    }
+    SortedSequence<int> sorted(array);
+    for (size_t i = 0; i < 10; ++i) {
+        REQUIRE(array[i] == array.Get(i));
+        REQUIRE(small[i] == small.Get(i));
+        REQUIRE(dynamic[i] == dynamic.Get(i));
+        REQUIRE(sorted[i] == sorted.Get(i));
+    }
+    // The public accessors check in every build.
+    REQUIRE_THROWS_AS(array.Get(10), std::out_of_range);
+    REQUIRE_THROWS_AS(small.Get(10), std::out_of_range);
+    REQUIRE_THROWS_AS(dynamic.Get(10), std::out_of_range);
+    REQUIRE_THROWS_AS(array.InsertAt(1, 11), std::out_of_range);
+    if constexpr (kCheckedAccess) {
+        REQUIRE_THROWS_AS(array[10], std::out_of_range);
+        REQUIRE_THROWS_AS(small[10], std::out_of_range);
+        REQUIRE_THROWS_AS(dynamic[10], std::out_of_range);
+        REQUIRE_THROWS_AS(sorted[10], std::out_of_range);
+    }
+}